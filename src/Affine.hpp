@@ -0,0 +1,77 @@
+#pragma once
+
+/**
+ * @file Affine.hpp
+ * @brief Affine header file.
+ * @author Connor J. Bramham (ReeCocho)
+ */
+
+/** Includes. */
+#include <glm\glm.hpp>
+
+namespace snk
+{
+	/**
+	 * @struct Affine
+	 * @brief 2D affine transformation with a depth offset.
+	 * @note Equivalent to a mat4 whose z axis is untouched, in 7 floats instead of 16.
+	 *		 Uploaded to shaders as is, so the layout must stay tightly packed.
+	 */
+	struct Affine
+	{
+		/** Linear part. The x axis is stored in xy and the y axis in zw. */
+		glm::vec4 basis = glm::vec4(1, 0, 0, 1);
+
+		/** Translation, with depth in z. */
+		glm::vec3 translation = glm::vec3(0, 0, 0);
+
+		/**
+		 * @brief Transform a point.
+		 * @param Point.
+		 * @return Transformed point.
+		 */
+		inline glm::vec3 transformPoint(glm::vec3 point) const
+		{
+			return glm::vec3
+			(
+				(basis.x * point.x) + (basis.z * point.y) + translation.x,
+				(basis.y * point.x) + (basis.w * point.y) + translation.y,
+				point.z + translation.z
+			);
+		}
+
+		/**
+		 * @brief Get the inverse transformation.
+		 * @return Inverse.
+		 * @note Only the 2x2 linear part has to be inverted.
+		 */
+		inline Affine inverse() const
+		{
+			float determinant = (basis.x * basis.w) - (basis.z * basis.y);
+			float inverseDeterminant = 1.0f / determinant;
+
+			Affine result = {};
+			result.basis = glm::vec4(basis.w, -basis.y, -basis.z, basis.x) * inverseDeterminant;
+			result.translation.x = -((result.basis.x * translation.x) + (result.basis.z * translation.y));
+			result.translation.y = -((result.basis.y * translation.x) + (result.basis.w * translation.y));
+			result.translation.z = -translation.z;
+			return result;
+		}
+
+		/**
+		 * @brief Get the equivalent 4x4 matrix.
+		 * @return Matrix.
+		 */
+		inline glm::mat4 toMatrix() const
+		{
+			glm::mat4 matrix = {};
+			matrix[0] = glm::vec4(basis.x, basis.y, 0, 0);
+			matrix[1] = glm::vec4(basis.z, basis.w, 0, 0);
+			matrix[2] = glm::vec4(0, 0, 1, 0);
+			matrix[3] = glm::vec4(translation.x, translation.y, translation.z, 1);
+			return matrix;
+		}
+	};
+
+	static_assert(sizeof(Affine) == 7 * sizeof(float), "Affine must be tightly packed.");
+}
\ No newline at end of file
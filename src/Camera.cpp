@@ -9,37 +9,38 @@ namespace snk
 
 	Camera::Camera(Scene* scene, Entity entity, ComponentID id) : Component(scene, entity, id)
 	{
-		setRunOnBegin(true);
-		setRunOnPreRender(true);
-	}
 
-	void Camera::onBegin()
-	{
-		m_transform = getEntity().getComponent<Transform>();
 	}
 
-	void Camera::onPreRender(float deltaTime)
+	void Camera::drawCameras(Scene* scene)
 	{
+		Renderer* renderer = Engine::get()->getRenderer();
 		float aspectRatio = static_cast<float>(Engine::get()->getGraphics()->getWidth()) / static_cast<float>(Engine::get()->getGraphics()->getHeight());
 
-		CameraData data = {};
-		data.view = glm::lookAt
-		(
-			m_transform->getPosition(),
-			m_transform->getPosition() + glm::vec3(0, 0, -1),
-			glm::vec3(m_transform->getUp(), 0)
-		);
-
-		data.projection = glm::ortho
-		(
-			-aspectRatio * (m_size / 2.0f), 
-			aspectRatio * (m_size / 2.0f), 
-			-m_size / 2.0f, 
-			m_size / 2.0f
-		);
-
-		data.mainCamera = this == mainCamera;
-
-		Engine::get()->getRenderer()->drawTo(data);
+		scene->query<Transform, Camera>().each([renderer, aspectRatio](Transform& transform, Camera& camera)
+		{
+			if (!camera.getRunOnPreRender())
+				return;
+
+			CameraData data = {};
+			data.view = glm::lookAt
+			(
+				transform.getPosition(),
+				transform.getPosition() + glm::vec3(0, 0, -1),
+				glm::vec3(transform.getUp(), 0)
+			);
+
+			data.projection = glm::ortho
+			(
+				-aspectRatio * (camera.m_size / 2.0f), 
+				aspectRatio * (camera.m_size / 2.0f), 
+				-camera.m_size / 2.0f, 
+				camera.m_size / 2.0f
+			);
+
+			data.mainCamera = &camera == mainCamera;
+
+			renderer->drawTo(data);
+		});
 	}
 }
\ No newline at end of file
@@ -34,16 +34,11 @@ namespace snk
 		~Camera() = default;
 
 		/**
-		 * @brief Called when the component is added to a game object.
-		 * @note Please use this for memory aquisition.
+		 * @brief Submit every camera in a scene to the renderer.
+		 * @param Scene to draw.
+		 * @note Registered as a pre-render system by the engine.
 		 */
-		void onBegin() override;
-
-		/**
-		 * @brief Called once per tick after onLateTick() but before presenting.
-		 * @param Time in seconds since last tick.
-		 */
-		void onPreRender(float deltaTime) override;
+		static void drawCameras(Scene* scene);
 
 		/**
 		 * @brief Set main camera.
@@ -90,9 +85,6 @@ namespace snk
 		/** Main camera. */
 		static Camera* mainCamera;
 
-		/** Camera's transform. */
-		Transform* m_transform = nullptr;
-
 		/** Size of the view window. */
 		float m_size = 5;
 	};
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "Component.hpp"
 
 namespace snk
@@ -33,6 +34,38 @@ namespace snk
 		return componentIDCount;
 	}
 
+	const std::vector<ComponentID>& Component::getAncestorIDs(ComponentID id)
+	{
+		return metaData[id].ancestors;
+	}
+
+	const std::vector<ComponentID>& Component::getDescendantIDs(ComponentID id)
+	{
+		return metaData[id].descendants;
+	}
+
+	void Component::linkPolymorphic(ComponentID parent, ComponentID child)
+	{
+		std::vector<ComponentID> ancestors = metaData[parent].ancestors;
+		ancestors.push_back(parent);
+
+		std::vector<ComponentID> descendants = metaData[child].descendants;
+		descendants.push_back(child);
+
+		// Every ancestor of the parent now inherits every descendant of the child
+		for (auto ancestor : ancestors)
+			for (auto descendant : descendants)
+			{
+				auto& down = metaData[ancestor].descendants;
+				if (std::find(down.begin(), down.end(), descendant) == down.end())
+					down.push_back(descendant);
+
+				auto& up = metaData[descendant].ancestors;
+				if (std::find(up.begin(), up.end(), ancestor) == up.end())
+					up.push_back(ancestor);
+			}
+	}
+
 	void Component::onBegin()
 	{
 
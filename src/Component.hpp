@@ -252,8 +252,23 @@ namespace snk
 			auto isnk = getUniqueID<T2>();
 
 			metaData[id1].children.push_back(isnk);
+			linkPolymorphic(id1, isnk);
 		}
 
+		/**
+		 * @brief Get every component type the given type inherits from.
+		 * @param Component ID.
+		 * @return Registered ancestors, direct and indirect.
+		 */
+		static const std::vector<ComponentID>& getAncestorIDs(ComponentID id);
+
+		/**
+		 * @brief Get every component type inheriting from the given type.
+		 * @param Component ID.
+		 * @return Registered descendants, direct and indirect.
+		 */
+		static const std::vector<ComponentID>& getDescendantIDs(ComponentID id);
+
 		/**
 		 * @brief Get the number of components registered.
 		 * @return Number of registered components.
@@ -281,8 +296,21 @@ namespace snk
 
 			/** Inherited classes. */
 			std::vector<ComponentID> children = {};
+
+			/** Every class this one inherits from. */
+			std::vector<ComponentID> ancestors = {};
+
+			/** Every class inheriting from this one. */
+			std::vector<ComponentID> descendants = {};
 		};
 
+		/**
+		 * @brief Update the ancestor and descendant lists after registering a relationship.
+		 * @param Parent component ID.
+		 * @param Child component ID.
+		 */
+		static void linkPolymorphic(ComponentID parent, ComponentID child);
+
 		/**
 		 * @brief Generate a new unique ID.
 		 * @return New unique ID.
@@ -334,4 +362,7 @@ namespace snk
 		/** Does the component run onEnd() */
 		bool m_runOnEnd = false;
 	};
-}
\ No newline at end of file
+}
+
+/** Scene.hpp needs a complete Component, so it is included last. */
+#include "Scene.hpp"
\ No newline at end of file
@@ -0,0 +1,368 @@
+#pragma once
+
+/**
+ * @file ComponentPool.hpp
+ * @brief Component pool header file.
+ * @author Connor J. Bramham (ReeCocho)
+ */
+
+/** Includes. */
+#include <memory>
+#include <vector>
+#include <limits>
+#include <utility>
+#include <type_traits>
+
+namespace snk
+{
+	class Component;
+
+	typedef size_t ComponentID;
+
+	/**
+	 * @class IComponentPool
+	 * @brief Type erased interface to a pool of components.
+	 * @see ComponentPool
+	 */
+	class IComponentPool
+	{
+	public:
+
+		/** Index used to mark an entity without a component in the pool. */
+		static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+		/**
+		 * @brief Default constructor.
+		 */
+		IComponentPool() = default;
+
+		/**
+		 * @brief Destructor.
+		 */
+		virtual ~IComponentPool() = default;
+
+		/**
+		 * @brief Get the number of components in the pool.
+		 * @return Number of components.
+		 */
+		inline size_t size() const
+		{
+			return m_entities.size();
+		}
+
+		/**
+		 * @brief Get the dense index of an entities component.
+		 * @param Entity index.
+		 * @return Dense index or npos if the entity has no component in the pool.
+		 */
+		inline size_t indexOf(size_t entity) const
+		{
+			return entity < m_sparse.size() ? m_sparse[entity] : npos;
+		}
+
+		/**
+		 * @brief Get if an entity has a component in the pool.
+		 * @param Entity index.
+		 * @return If the entity has a component in the pool.
+		 */
+		inline bool contains(size_t entity) const
+		{
+			return indexOf(entity) != npos;
+		}
+
+		/**
+		 * @brief Get the entity owning the component at a dense index.
+		 * @param Dense index.
+		 * @return Entity index.
+		 */
+		inline size_t getEntity(size_t index) const
+		{
+			return m_entities[index];
+		}
+
+		/**
+		 * @brief Get if the component type overrides onTick().
+		 * @return If the pool needs to run onTick().
+		 */
+		inline bool runsTick() const
+		{
+			return m_runsTick;
+		}
+
+		/**
+		 * @brief Get if the component type overrides onLateTick().
+		 * @return If the pool needs to run onLateTick().
+		 */
+		inline bool runsLateTick() const
+		{
+			return m_runsLateTick;
+		}
+
+		/**
+		 * @brief Get if the component type overrides onPreRender().
+		 * @return If the pool needs to run onPreRender().
+		 */
+		inline bool runsPreRender() const
+		{
+			return m_runsPreRender;
+		}
+
+		/**
+		 * @brief Get an entities component.
+		 * @param Entity index.
+		 * @return Component or nullptr if the entity has none in the pool.
+		 */
+		virtual Component* get(size_t entity) = 0;
+
+		/**
+		 * @brief Get the component at a dense index.
+		 * @param Dense index.
+		 * @return Component.
+		 */
+		virtual Component* at(size_t index) = 0;
+
+		/**
+		 * @brief Destroy an entities component.
+		 * @param Entity index.
+		 * @note The last component in the pool is moved into the freed slot.
+		 */
+		virtual void remove(size_t entity) = 0;
+
+		/**
+		 * @brief Swap the components at two dense indices.
+		 * @param First dense index.
+		 * @param Second dense index.
+		 */
+		virtual void swap(size_t a, size_t b) = 0;
+
+		/**
+		 * @brief Run onTick() on every component in the pool.
+		 * @param Time in seconds since last tick.
+		 */
+		virtual void tick(float deltaTime) = 0;
+
+		/**
+		 * @brief Run onLateTick() on every component in the pool.
+		 * @param Time in seconds since last tick.
+		 */
+		virtual void lateTick(float deltaTime) = 0;
+
+		/**
+		 * @brief Run onPreRender() on every component in the pool.
+		 * @param Time in seconds since last tick.
+		 */
+		virtual void preRender(float deltaTime) = 0;
+
+		/**
+		 * @brief Run onEnd() on every component in the pool.
+		 */
+		virtual void end() = 0;
+
+	protected:
+
+		/**
+		 * @brief Map an entity to a dense index.
+		 * @param Entity index.
+		 * @param Dense index.
+		 */
+		inline void setIndex(size_t entity, size_t index)
+		{
+			if (entity >= m_sparse.size())
+				m_sparse.resize(entity + 1, npos);
+
+			m_sparse[entity] = index;
+		}
+
+		/** Entity index to dense index. */
+		std::vector<size_t> m_sparse = {};
+
+		/** Dense index to entity index. */
+		std::vector<size_t> m_entities = {};
+
+		/** Does the component type override onTick() */
+		bool m_runsTick = false;
+
+		/** Does the component type override onLateTick() */
+		bool m_runsLateTick = false;
+
+		/** Does the component type override onPreRender() */
+		bool m_runsPreRender = false;
+	};
+
+	/**
+	 * @class ComponentPool
+	 * @brief Stores every component of type T contiguously.
+	 * @note Components live in fixed size pages so growing the pool never moves them.
+	 *		 Destroying a component moves the last component of the pool into its slot,
+	 *		 so pointers are only stable until a component of the same type is destroyed.
+	 */
+	template<class T>
+	class ComponentPool : public IComponentPool
+	{
+	public:
+
+		/** Number of components per page. */
+		static constexpr size_t pageSize = 256;
+
+		/**
+		 * @brief Default constructor.
+		 * @note Phases the type doesn't override are skipped by the scene entirely.
+		 */
+		ComponentPool()
+		{
+			m_runsTick = !std::is_same<decltype(&T::onTick), void (Component::*)(float)>::value;
+			m_runsLateTick = !std::is_same<decltype(&T::onLateTick), void (Component::*)(float)>::value;
+			m_runsPreRender = !std::is_same<decltype(&T::onPreRender), void (Component::*)(float)>::value;
+		}
+
+		/**
+		 * @brief Destructor.
+		 */
+		~ComponentPool()
+		{
+			for (size_t i = 0; i < size(); i++)
+				slot(i)->~T();
+		}
+
+		/**
+		 * @brief Construct a component for an entity.
+		 * @param Entity index.
+		 * @param Arguments to pass to the components constructor.
+		 * @return New component.
+		 */
+		template<class... Args>
+		T* add(size_t entity, Args&&... args)
+		{
+			size_t index = size();
+
+			if (index / pageSize >= m_pages.size())
+				m_pages.push_back(std::make_unique<Page>());
+
+			T* component = new (slot(index)) T(std::forward<Args>(args)...);
+			m_entities.push_back(entity);
+			setIndex(entity, index);
+
+			return component;
+		}
+
+		/**
+		 * @brief Get the component at a dense index.
+		 * @param Dense index.
+		 * @return Component.
+		 */
+		inline T* slot(size_t index)
+		{
+			return reinterpret_cast<T*>(&m_pages[index / pageSize]->data[index % pageSize]);
+		}
+
+		Component* get(size_t entity) override
+		{
+			size_t index = indexOf(entity);
+			return index == npos ? nullptr : slot(index);
+		}
+
+		Component* at(size_t index) override
+		{
+			return slot(index);
+		}
+
+		void remove(size_t entity) override
+		{
+			size_t index = indexOf(entity);
+			if (index == npos)
+				return;
+
+			size_t last = size() - 1;
+			slot(index)->~T();
+
+			// Fill the hole with the last component
+			if (index != last)
+			{
+				new (slot(index)) T(std::move(*slot(last)));
+				slot(last)->~T();
+
+				m_entities[index] = m_entities[last];
+				m_sparse[m_entities[index]] = index;
+			}
+
+			m_entities.pop_back();
+			m_sparse[entity] = npos;
+		}
+
+		void swap(size_t a, size_t b) override
+		{
+			if (a == b)
+				return;
+
+			// Components are moved through a temporary so they are never assigned
+			typename std::aligned_storage<sizeof(T), alignof(T)>::type temp;
+			T* tempComponent = new (&temp) T(std::move(*slot(a)));
+			slot(a)->~T();
+
+			new (slot(a)) T(std::move(*slot(b)));
+			slot(b)->~T();
+
+			new (slot(b)) T(std::move(*tempComponent));
+			tempComponent->~T();
+
+			std::swap(m_entities[a], m_entities[b]);
+			m_sparse[m_entities[a]] = a;
+			m_sparse[m_entities[b]] = b;
+		}
+
+		void tick(float deltaTime) override
+		{
+			for (size_t i = 0; i < size(); i++)
+			{
+				T* component = slot(i);
+				if (component->getRunOnTick())
+					component->T::onTick(deltaTime);
+			}
+		}
+
+		void lateTick(float deltaTime) override
+		{
+			for (size_t i = 0; i < size(); i++)
+			{
+				T* component = slot(i);
+				if (component->getRunOnLateTick())
+					component->T::onLateTick(deltaTime);
+			}
+		}
+
+		void preRender(float deltaTime) override
+		{
+			for (size_t i = 0; i < size(); i++)
+			{
+				T* component = slot(i);
+				if (component->getRunOnPreRender())
+					component->T::onPreRender(deltaTime);
+			}
+		}
+
+		void end() override
+		{
+			for (size_t i = 0; i < size(); i++)
+			{
+				T* component = slot(i);
+				if (component->getRunOnEnd())
+					component->T::onEnd();
+			}
+		}
+
+	private:
+
+		/**
+		 * @struct Page
+		 * @brief Uninitialized storage for a page of components.
+		 */
+		struct Page
+		{
+			/** Component storage. */
+			typename std::aligned_storage<sizeof(T), alignof(T)>::type data[pageSize];
+		};
+
+		/** Pages of components. */
+		std::vector<std::unique_ptr<Page>> m_pages = {};
+	};
+}
\ No newline at end of file
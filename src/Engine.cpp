@@ -1,4 +1,6 @@
 #include "Engine.hpp"
+#include "Camera.hpp"
+#include "SpriteRenderer.hpp"
 
 namespace snk
 {
@@ -6,29 +8,45 @@ namespace snk
 
 
 
-	Engine::Engine(const std::string& name, uint32_t width, uint32_t height)
+	Engine::Engine(const std::string& name, uint32_t width, uint32_t height, size_t maxFramesInFlight)
 	{
-		m_threadPool = std::make_unique<ThreadPool>(1);
+		m_threadPool = std::make_unique<ThreadPool>();
+		m_renderThread = std::make_unique<WorkerThread>();
 		m_input = std::make_unique<Input>();
 		m_graphics = std::make_unique<Graphics>(name, width, height);
-		m_renderer = std::make_unique<Renderer>(m_graphics.get());
+		m_renderer = std::make_unique<Renderer>(m_graphics.get(), maxFramesInFlight);
 		m_scene = std::make_unique<Scene>();
+		m_scene->setThreadPool(m_threadPool.get());
+
+		// Built in systems
+		m_scene->addSystem(SystemPhase::PreRender, SystemAccess().write<Transform>(), [this](float) { m_scene->resolveTransforms(); });
+		m_scene->addSystem(SystemPhase::PreRender, SystemAccess().read<Transform, Camera>(), [this](float) { Camera::drawCameras(m_scene.get()); });
+		m_scene->addSystem(SystemPhase::PreRender, SystemAccess().read<Transform, SpriteRenderer>(), [this](float) { SpriteRenderer::drawSprites(m_scene.get()); });
 	}
 
 	Engine::~Engine()
 	{
+		m_renderThread->wait();
 		m_threadPool->wait();
 
+		// GL objects belong to the render thread
+		if (m_renderer)
+		{
+			m_renderThread->addJob([this]() { m_renderer->release(); });
+			m_renderThread->wait();
+		}
+
 		m_scene = nullptr;
+		m_renderThread = nullptr;
 		m_threadPool = nullptr;
 		m_renderer = nullptr;
 		m_graphics = nullptr;
 		m_input = nullptr;
 	}
 
-	void Engine::initialize(const std::string& name, uint32_t width, uint32_t height)
+	void Engine::initialize(const std::string& name, uint32_t width, uint32_t height, size_t maxFramesInFlight)
 	{
-		singleton = std::make_unique<Engine>(name, width, height);
+		singleton = std::make_unique<Engine>(name, width, height, maxFramesInFlight);
 	}
 
 	void Engine::start()
@@ -36,15 +54,13 @@ namespace snk
 		// Variables used for delta time
 		uint64_t currentTick = SDL_GetPerformanceCounter();
 		uint64_t lastTick = SDL_GetPerformanceCounter();
+		float time = 0;
 
 		while (!singleton->m_input->isClosing())
 		{
 			// Get input events
 			singleton->m_input->pollEvents();
 
-			// Wait for the thread sto finish
-			singleton->m_threadPool->wait();
-
 			// Bind the context to the main thread
 			singleton->m_graphics->bindMainContext();
 
@@ -55,21 +71,30 @@ namespace snk
 			// Perform a tick in the scene
 			singleton->m_scene->tick(deltaTime);
 
-			// Rendering
-			singleton->m_threadPool->workers[0]->addJob([]() { singleton->m_renderer->render(); });
+			time += deltaTime;
+
+			// Render the frame while the next one ticks
+			size_t packet = singleton->m_renderer->submit(time);
+			singleton->m_renderThread->addJob([packet]() { singleton->m_renderer->render(packet); });
 
 			// Set the last tick count to the current tick count
 			lastTick = currentTick;
 		}
 
 		// Wait for the thread sto finish
+		singleton->m_renderThread->wait();
 		singleton->m_threadPool->wait();
 	}
 
 	void Engine::stop()
 	{
+		singleton->m_renderThread->wait();
 		singleton->m_threadPool->wait();
 
+		// GL objects belong to the render thread
+		singleton->m_renderThread->addJob([]() { singleton->m_renderer->release(); });
+		singleton->m_renderThread->wait();
+
 		singleton->m_scene = nullptr;
 		singleton->m_renderer = nullptr;
 		singleton->m_graphics = nullptr;
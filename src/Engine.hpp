@@ -36,8 +36,9 @@ namespace snk
 		 * @param Window name.
 		 * @param Window width.
 		 * @param Window height.
+		 * @param Maximum number of frames rendering while the scene ticks.
 		 */
-		Engine(const std::string& name, uint32_t width, uint32_t height);
+		Engine(const std::string& name, uint32_t width, uint32_t height, size_t maxFramesInFlight = 1);
 
 		/**
 		 * @brief Destructor.
@@ -58,8 +59,9 @@ namespace snk
 		 * @param Window name.
 		 * @param Window width.
 		 * @param Window height.
+		 * @param Maximum number of frames rendering while the scene ticks.
 		 */
-		static void initialize(const std::string& name, uint32_t width, uint32_t height);
+		static void initialize(const std::string& name, uint32_t width, uint32_t height, size_t maxFramesInFlight = 1);
 
 		/**
 		 * @brief Start the engine.
@@ -98,6 +100,15 @@ namespace snk
 			return m_renderer.get();
 		}
 
+		/**
+		 * @brief Get thread pool.
+		 * @return Thread pool.
+		 */
+		inline ThreadPool* getThreadPool()
+		{
+			return m_threadPool.get();
+		}
+
 		/**
 		 * @brief Get scene manager.
 		 * @return Scene manager.
@@ -115,6 +126,9 @@ namespace snk
 		/** Thread pool. */
 		std::unique_ptr<ThreadPool> m_threadPool;
 
+		/** Thread the renderer runs on. The GL context must stay on one thread. */
+		std::unique_ptr<WorkerThread> m_renderThread;
+
 		/** Input manager. */
 		std::unique_ptr<Input> m_input;
 
@@ -2,7 +2,7 @@
 
 namespace snk
 {
-	Entity::Entity(Scene* scene, size_t handle) : m_scene(scene), m_handle(handle)
+	Entity::Entity(Scene* scene, EntityHandle handle) : m_scene(scene), m_handle(handle)
 	{
 		
 	}
@@ -11,4 +11,14 @@ namespace snk
 	{
 		m_handle = m_scene->create();
 	}
+
+	void Entity::destroy()
+	{
+		m_scene->destroy(m_handle);
+	}
+
+	bool Entity::isValid() const
+	{
+		return m_scene != nullptr && m_scene->isValid(m_handle);
+	}
 }
\ No newline at end of file
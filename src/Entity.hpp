@@ -7,7 +7,8 @@
  */
 
 /** Includes. */
-#include "Scene.hpp"
+#include <cstddef>
+#include <cstdint>
 
 namespace snk
 {
@@ -15,6 +16,13 @@ namespace snk
 
 	typedef size_t ComponentID;
 
+	/**
+	 * @typedef EntityHandle
+	 * @brief Entity index in the low 32 bits and its generation in the high 32 bits.
+	 * @note A handle goes stale once its entity is destroyed, even if the index is reused.
+	 */
+	typedef uint64_t EntityHandle;
+
 	/**
 	 * @class Entity
 	 * @brief Allows for interfacing with an entities components.
@@ -34,7 +42,7 @@ namespace snk
 		 * @param Scene the entity is in.
 		 * @param Entities handle.
 		 */
-		Entity(Scene* scene, size_t handle);
+		Entity(Scene* scene, EntityHandle handle);
 
 		/**
 		 * @brief Constructor.
@@ -51,20 +59,54 @@ namespace snk
 		/**
 		 * @brief Destoy this entity.
 		 */
-		inline void destroy()
-			{
-				m_scene->destroy(m_handle);
-			}
+		void destroy();
+
+		/**
+		 * @brief Get if the entity still exists.
+		 * @return If the entity still exists.
+		 */
+		bool isValid() const;
 
 		/**
 		 * @brief Get handle.
 		 * @return Handle.
 		 */
-		inline size_t getHandle() const
+		inline EntityHandle getHandle() const
 			{
 				return m_handle;
 			}
 
+		/**
+		 * @brief Build a handle.
+		 * @param Entity index.
+		 * @param Entity generation.
+		 * @return Handle.
+		 */
+		static inline EntityHandle makeHandle(uint32_t index, uint32_t generation)
+			{
+				return (static_cast<EntityHandle>(generation) << 32) | index;
+			}
+
+		/**
+		 * @brief Get the index part of a handle.
+		 * @param Handle.
+		 * @return Entity index.
+		 */
+		static inline uint32_t getIndex(EntityHandle handle)
+			{
+				return static_cast<uint32_t>(handle);
+			}
+
+		/**
+		 * @brief Get the generation part of a handle.
+		 * @param Handle.
+		 * @return Entity generation.
+		 */
+		static inline uint32_t getGeneration(EntityHandle handle)
+			{
+				return static_cast<uint32_t>(handle >> 32);
+			}
+
 		/**
 		 * @brief Get scene.
 		 * @return Scene.
@@ -79,10 +121,7 @@ namespace snk
 		 * @return If the entity has the component.
 		 */
 		template<class T>
-		bool hasComponent()
-			{
-				return m_scene->hasComponent<T>(m_handle);
-			}
+		bool hasComponent();
 
 		/**
 		 * @brief Get a component on the entity.
@@ -90,37 +129,34 @@ namespace snk
 		 * @note Returns nullptr if the entity doesn't contain the component.
 		 */
 		template<class T>
-		T* getComponent()
-			{
-				return m_scene->getComponent<T>(m_handle);
-			}
+		T* getComponent();
 
 		/**
 		 * @brief Add a new component to the entity.
 		 * @return Pointer to new component.
 		 * @note If the entity already contains a component of the same type it will return that instead.
+		 *		 If the type belongs to a registered archetype, components of that archetype may move,
+		 *		 invalidating pointers to them.
+		 * @see Scene::registerArchetype
 		 */
 		template<class T>
-		T* addComponent()
-			{
-				return m_scene->addComponent<T>(m_handle);
-			}
+		T* addComponent();
 
 		/**
 		* @brief Removes a component from the entity.
 		*/
 		template<class T>
-		void removeComponent()
-			{
-				m_scene->removeComponent<T>(m_handle);
-			}
+		void removeComponent();
 
 	private:
 
 		/** Scene. */
-		Scene* m_scene;
+		Scene* m_scene = nullptr;
 
 		/** Handle. */
-		size_t m_handle;
+		EntityHandle m_handle = 0;
 	};
-}
\ No newline at end of file
+}
+
+/** Scene.hpp defines the entity templates, reached through Component.hpp. */
+#include "Component.hpp"
\ No newline at end of file
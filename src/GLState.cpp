@@ -0,0 +1,184 @@
+#include <cstring>
+#include <glm\gtc\type_ptr.hpp>
+#include "GLState.hpp"
+
+namespace snk
+{
+	void GLState::invalidate()
+	{
+		m_program = unknown;
+		m_vao = unknown;
+		m_activeUnit = unknown;
+		m_material = unknown;
+		m_materialProgram = unknown;
+
+		for (size_t i = 0; i < textureUnits; i++)
+			m_textures[i] = unknown;
+	}
+
+	void GLState::forgetProgram(GLuint program)
+	{
+		// Shader destructors unbind whatever program is bound, so the cache has to agree
+		useProgram(0);
+
+		if (m_materialProgram == program)
+		{
+			m_material = unknown;
+			m_materialProgram = unknown;
+		}
+
+		m_uniforms.erase(program);
+	}
+
+	bool GLState::useMaterial(uint32_t material, GLuint program)
+	{
+		if (m_material == material && m_materialProgram == program)
+		{
+			m_counters.skipped++;
+			return false;
+		}
+
+		m_material = material;
+		m_materialProgram = program;
+		return true;
+	}
+
+	void GLState::useProgram(GLuint program)
+	{
+		if (m_program == program)
+		{
+			m_counters.skipped++;
+			return;
+		}
+
+		glUseProgram(program);
+		m_program = program;
+		m_programUniforms = &m_uniforms[program];
+		m_counters.issued++;
+	}
+
+	void GLState::bindVertexArray(GLuint vao)
+	{
+		if (m_vao == vao)
+		{
+			m_counters.skipped++;
+			return;
+		}
+
+		glBindVertexArray(vao);
+		m_vao = vao;
+		m_counters.issued++;
+	}
+
+	void GLState::bindTexture(GLuint unit, GLuint texture)
+	{
+		if (unit < textureUnits && m_textures[unit] == texture)
+		{
+			m_counters.skipped++;
+			return;
+		}
+
+		if (m_activeUnit != unit)
+		{
+			glActiveTexture(GL_TEXTURE0 + unit);
+			m_activeUnit = unit;
+		}
+
+		glBindTexture(GL_TEXTURE_2D, texture);
+		m_counters.issued++;
+
+		if (unit < textureUnits)
+			m_textures[unit] = texture;
+	}
+
+	void GLState::setUniform(GLint location, float value)
+	{
+		if (cacheUniform(location, &value, 1))
+			glUniform1f(location, value);
+	}
+
+	void GLState::setUniform(GLint location, int value)
+	{
+		if (cacheUniform(location, &value, 1))
+			glUniform1i(location, value);
+	}
+
+	void GLState::setUniform(GLint location, const glm::vec2& value)
+	{
+		if (cacheUniform(location, glm::value_ptr(value), 2))
+			glUniform2f(location, value.x, value.y);
+	}
+
+	void GLState::setUniform(GLint location, const glm::vec3& value)
+	{
+		if (cacheUniform(location, glm::value_ptr(value), 3))
+			glUniform3f(location, value.x, value.y, value.z);
+	}
+
+	void GLState::setUniform(GLint location, const glm::vec4& value)
+	{
+		if (cacheUniform(location, glm::value_ptr(value), 4))
+			glUniform4f(location, value.x, value.y, value.z, value.w);
+	}
+
+	void GLState::setUniform(GLint location, const glm::mat4& value)
+	{
+		if (cacheUniform(location, glm::value_ptr(value), 16))
+			glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+	}
+
+	void GLState::setUniform(GLint location, const float* value, size_t size)
+	{
+		if (!cacheUniform(location, value, size))
+			return;
+
+		switch (size)
+		{
+		case 1:
+			glUniform1fv(location, 1, value);
+			break;
+
+		case 2:
+			glUniform2fv(location, 1, value);
+			break;
+
+		case 3:
+			glUniform3fv(location, 1, value);
+			break;
+
+		case 4:
+			glUniform4fv(location, 1, value);
+			break;
+
+		case 16:
+			glUniformMatrix4fv(location, 1, GL_FALSE, value);
+			break;
+		}
+	}
+
+	bool GLState::cacheUniform(GLint location, const void* data, size_t size)
+	{
+		// GL ignores uniforms that don't exist
+		if (location < 0 || m_programUniforms == nullptr)
+		{
+			m_counters.skipped++;
+			return false;
+		}
+
+		auto& uniforms = *m_programUniforms;
+		if (static_cast<size_t>(location) >= uniforms.size())
+			uniforms.resize(location + 1);
+
+		UniformValue& uniform = uniforms[location];
+		if (uniform.size == size && std::memcmp(uniform.data, data, size * sizeof(float)) == 0)
+		{
+			m_counters.skipped++;
+			return false;
+		}
+
+		std::memcpy(uniform.data, data, size * sizeof(float));
+		uniform.size = size;
+		m_counters.issued++;
+		return true;
+	}
+}
\ No newline at end of file
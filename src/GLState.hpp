@@ -0,0 +1,212 @@
+#pragma once
+
+/**
+ * @file GLState.hpp
+ * @brief GL state cache header file.
+ * @author Connor J. Bramham (ReeCocho)
+ */
+
+/** Includes. */
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <glm\glm.hpp>
+#include <glad\glad.h>
+
+namespace snk
+{
+	/**
+	 * @struct GLStateCounters
+	 * @brief Number of state changes issued to GL and skipped by the cache.
+	 */
+	struct GLStateCounters
+	{
+		/** State changes sent to GL. */
+		size_t issued = 0;
+
+		/** State changes that matched the cache. */
+		size_t skipped = 0;
+	};
+
+	/**
+	 * @class GLState
+	 * @brief Remembers bound GL state so redundant calls can be skipped.
+	 * @note Render thread only. Uniform values are cached per program and survive invalidate().
+	 */
+	class GLState
+	{
+	public:
+
+		/** Number of texture units tracked. */
+		static constexpr size_t textureUnits = 32;
+
+		/**
+		 * @brief Default constructor.
+		 */
+		GLState()
+		{
+			invalidate();
+		}
+
+		/**
+		 * @brief Forget every binding, so the next one of each kind is issued.
+		 * @note Call when something outside the cache may have changed bindings.
+		 */
+		void invalidate();
+
+		/**
+		 * @brief Get the counters.
+		 * @return Counters since the last reset.
+		 */
+		inline const GLStateCounters& getCounters() const
+		{
+			return m_counters;
+		}
+
+		/**
+		 * @brief Reset the counters.
+		 */
+		inline void resetCounters()
+		{
+			m_counters = {};
+		}
+
+		/**
+		 * @brief Forget everything cached about a program before it is deleted.
+		 * @param Program.
+		 * @note Unbinds any program, as the shader destructor does, so GL can reuse the ID safely.
+		 */
+		void forgetProgram(GLuint program);
+
+		/**
+		 * @brief Mark a material as the one whose state is bound.
+		 * @param Unique ID of the material.
+		 * @param Program the material is bound to.
+		 * @return If the material wasn't already bound to the program.
+		 */
+		bool useMaterial(uint32_t material, GLuint program);
+
+		/**
+		 * @brief Bind a shader program.
+		 * @param Program.
+		 */
+		void useProgram(GLuint program);
+
+		/**
+		 * @brief Bind a vertex array object.
+		 * @param Vertex array object.
+		 */
+		void bindVertexArray(GLuint vao);
+
+		/**
+		 * @brief Bind a 2D texture to a texture unit.
+		 * @param Texture unit.
+		 * @param Texture.
+		 */
+		void bindTexture(GLuint unit, GLuint texture);
+
+		/**
+		 * @brief Set a uniform of the bound program.
+		 * @param Uniform location.
+		 * @param Value.
+		 */
+		void setUniform(GLint location, float value);
+
+		/**
+		 * @brief Set a uniform of the bound program.
+		 * @param Uniform location.
+		 * @param Value.
+		 */
+		void setUniform(GLint location, int value);
+
+		/**
+		 * @brief Set a uniform of the bound program.
+		 * @param Uniform location.
+		 * @param Value.
+		 */
+		void setUniform(GLint location, const glm::vec2& value);
+
+		/**
+		 * @brief Set a uniform of the bound program.
+		 * @param Uniform location.
+		 * @param Value.
+		 */
+		void setUniform(GLint location, const glm::vec3& value);
+
+		/**
+		 * @brief Set a uniform of the bound program.
+		 * @param Uniform location.
+		 * @param Value.
+		 */
+		void setUniform(GLint location, const glm::vec4& value);
+
+		/**
+		 * @brief Set a uniform of the bound program.
+		 * @param Uniform location.
+		 * @param Value.
+		 */
+		void setUniform(GLint location, const glm::mat4& value);
+
+		/**
+		 * @brief Set a float, vector, or matrix uniform of the bound program.
+		 * @param Uniform location.
+		 * @param Value.
+		 * @param Number of floats in the value. 1 to 4 for floats and vectors, 16 for a mat4.
+		 */
+		void setUniform(GLint location, const float* value, size_t size);
+
+	private:
+
+		/** Binding that matches nothing, used for state the cache doesn't know. */
+		static constexpr GLuint unknown = ~static_cast<GLuint>(0);
+
+		/**
+		 * @struct UniformValue
+		 * @brief Last value uploaded to a uniform.
+		 */
+		struct UniformValue
+		{
+			/** Value, bit for bit. */
+			float data[16] = {};
+
+			/** Number of floats in the value, 0 if unknown. */
+			size_t size = 0;
+		};
+
+		/**
+		 * @brief Update the cached value of a uniform of the bound program.
+		 * @param Uniform location.
+		 * @param Value.
+		 * @param Number of floats in the value.
+		 * @return If the value changed and must be uploaded.
+		 */
+		bool cacheUniform(GLint location, const void* data, size_t size);
+
+		/** Bound program. */
+		GLuint m_program = 0;
+
+		/** Bound vertex array object. */
+		GLuint m_vao = 0;
+
+		/** Active texture unit. */
+		GLuint m_activeUnit = 0;
+
+		/** Texture bound to each unit. */
+		GLuint m_textures[textureUnits] = {};
+
+		/** ID of the material whose state is bound. */
+		uint32_t m_material = unknown;
+
+		/** Program the material is bound to. */
+		GLuint m_materialProgram = unknown;
+
+		/** Uniform values of every program, indexed by location. */
+		std::unordered_map<GLuint, std::vector<UniformValue>> m_uniforms = {};
+
+		/** Uniform values of the bound program. */
+		std::vector<UniformValue>* m_programUniforms = nullptr;
+
+		/** Counters. */
+		GLStateCounters m_counters = {};
+	};
+}
\ No newline at end of file
@@ -0,0 +1,257 @@
+#pragma once
+
+/**
+ * @file Job.hpp
+ * @brief Job header file.
+ * @author Connor J. Bramham (ReeCocho)
+ */
+
+/** Includes. */
+#include <new>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+namespace snk
+{
+	/**
+	 * @class Job
+	 * @brief Move only function object that stores its capture inline.
+	 * @note Captures larger than captureSize are rejected at compile time, so
+	 *		 creating and moving a job never touches the heap.
+	 */
+	class Job
+	{
+	public:
+
+		/** Bytes of inline capture storage. */
+		static constexpr size_t captureSize = 48;
+
+		/**
+		 * @brief Default constructor.
+		 */
+		Job() = default;
+
+		/**
+		 * @brief Constructor.
+		 * @param Function to run.
+		 */
+		template<class Function, class = typename std::enable_if<!std::is_same<typename std::decay<Function>::type, Job>::value>::type>
+		Job(Function&& function)
+		{
+			typedef typename std::decay<Function>::type FunctionType;
+			static_assert(sizeof(FunctionType) <= captureSize, "Job capture is too large.");
+			static_assert(alignof(FunctionType) <= alignof(Storage), "Job capture is over aligned.");
+
+			new (&m_storage) FunctionType(std::forward<Function>(function));
+			m_invoke = &invoke<FunctionType>;
+			m_manage = &manage<FunctionType>;
+		}
+
+		/**
+		 * @brief Move constructor.
+		 * @param Job to move.
+		 */
+		Job(Job&& other)
+		{
+			*this = std::move(other);
+		}
+
+		/**
+		 * @brief Destructor.
+		 */
+		~Job()
+		{
+			reset();
+		}
+
+		Job(const Job&) = delete;
+
+		Job& operator=(const Job&) = delete;
+
+		/**
+		 * @brief Move assignment operator.
+		 * @param Job to move.
+		 * @return This job.
+		 */
+		Job& operator=(Job&& other)
+		{
+			if (this != &other)
+			{
+				reset();
+
+				if (other.m_manage)
+				{
+					other.m_manage(&m_storage, &other.m_storage);
+					m_invoke = other.m_invoke;
+					m_manage = other.m_manage;
+					other.reset();
+				}
+			}
+
+			return *this;
+		}
+
+		/**
+		 * @brief Run the job.
+		 */
+		inline void operator()()
+		{
+			m_invoke(&m_storage);
+		}
+
+		/**
+		 * @brief Get if the job holds a function.
+		 * @return If the job holds a function.
+		 */
+		inline explicit operator bool() const
+		{
+			return m_invoke != nullptr;
+		}
+
+		/**
+		 * @brief Destroy the held function.
+		 */
+		inline void reset()
+		{
+			if (m_manage)
+				m_manage(nullptr, &m_storage);
+
+			m_invoke = nullptr;
+			m_manage = nullptr;
+		}
+
+	private:
+
+		/** Capture storage type. */
+		typedef typename std::aligned_storage<captureSize, alignof(std::max_align_t)>::type Storage;
+
+		/**
+		 * @brief Run a stored function.
+		 * @param Storage holding the function.
+		 */
+		template<class FunctionType>
+		static void invoke(void* storage)
+		{
+			(*static_cast<FunctionType*>(storage))();
+		}
+
+		/**
+		 * @brief Move or destroy a stored function.
+		 * @param Storage to move the function into, or nullptr to destroy it.
+		 * @param Storage holding the function.
+		 */
+		template<class FunctionType>
+		static void manage(void* destination, void* source)
+		{
+			if (destination)
+				new (destination) FunctionType(std::move(*static_cast<FunctionType*>(source)));
+			else
+				static_cast<FunctionType*>(source)->~FunctionType();
+		}
+
+		/** Capture storage. */
+		Storage m_storage;
+
+		/** Function running the capture. */
+		void(*m_invoke)(void*) = nullptr;
+
+		/** Function moving and destroying the capture. */
+		void(*m_manage)(void*, void*) = nullptr;
+	};
+
+	/**
+	 * @class JobBuffer
+	 * @brief Double ended ring buffer of job records.
+	 * @note Slots are reused, so a buffer only allocates when it grows past its largest size.
+	 */
+	template<class T>
+	class JobBuffer
+	{
+	public:
+
+		/**
+		 * @brief Default constructor.
+		 */
+		JobBuffer() = default;
+
+		/**
+		 * @brief Get the number of records.
+		 * @return Number of records.
+		 */
+		inline size_t size() const
+		{
+			return m_size;
+		}
+
+		/**
+		 * @brief Get if the buffer is empty.
+		 * @return If the buffer is empty.
+		 */
+		inline bool empty() const
+		{
+			return m_size == 0;
+		}
+
+		/**
+		 * @brief Add a record to the back.
+		 * @param Record.
+		 */
+		void push_back(T&& record)
+		{
+			if (m_size == m_records.size())
+				grow();
+
+			m_records[(m_head + m_size) % m_records.size()] = std::move(record);
+			m_size++;
+		}
+
+		/**
+		 * @brief Remove the record at the back.
+		 * @return Record.
+		 */
+		T pop_back()
+		{
+			m_size--;
+			return std::move(m_records[(m_head + m_size) % m_records.size()]);
+		}
+
+		/**
+		 * @brief Remove the record at the front.
+		 * @return Record.
+		 */
+		T pop_front()
+		{
+			T record = std::move(m_records[m_head]);
+			m_head = (m_head + 1) % m_records.size();
+			m_size--;
+			return record;
+		}
+
+	private:
+
+		/**
+		 * @brief Double the capacity, keeping records in order.
+		 */
+		void grow()
+		{
+			std::vector<T> records(m_records.size() == 0 ? 64 : m_records.size() * 2);
+
+			for (size_t i = 0; i < m_size; i++)
+				records[i] = std::move(m_records[(m_head + i) % m_records.size()]);
+
+			m_records = std::move(records);
+			m_head = 0;
+		}
+
+		/** Record slots. */
+		std::vector<T> m_records = {};
+
+		/** Slot of the front record. */
+		size_t m_head = 0;
+
+		/** Number of records. */
+		size_t m_size = 0;
+	};
+}
\ No newline at end of file
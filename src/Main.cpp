@@ -32,6 +32,9 @@ int main()
 
 	snk::Engine::initialize("Snek", 800, 800);
 
+	// Cache linked shader programs in the working directory
+	snk::Shader::setCacheDirectory("./");
+
 	// Setup input
 	snk::Engine::get()->getInput()->registerAxis("Horizontal", { { snk::KeyCode::A, -1.0f },{ snk::KeyCode::D, 1.0f } });
 	snk::Engine::get()->getInput()->registerAxis("Vertical", { { snk::KeyCode::W, 1.0f },{ snk::KeyCode::S, -1.0f } });
@@ -66,8 +69,8 @@ int main()
 		}
 
 #ifndef NDEBUG
-		auto box = std::make_unique<snk::Sprite>("../../src/Sprites/Box.png", snk::TextureFiltering::Linear, snk::TextureWrap::Clamp);
-		auto circle = std::make_unique<snk::Sprite>("../../src/Sprites/Circle.png", snk::TextureFiltering::Linear, snk::TextureWrap::Clamp);
+		auto box = std::make_unique<snk::Sprite>("../../src/Sprites/Box.png", snk::TextureFiltering::Linear, snk::TextureWrap::Clamp, *snk::Engine::get()->getThreadPool());
+		auto circle = std::make_unique<snk::Sprite>("../../src/Sprites/Circle.png", snk::TextureFiltering::Linear, snk::TextureWrap::Clamp, *snk::Engine::get()->getThreadPool());
 
 		// Shaders
 		std::unique_ptr<snk::Shader> shader;
@@ -77,8 +80,8 @@ int main()
 			shader = std::make_unique<snk::Shader>(vSource, fSource);
 		}
 #else
-		auto box = std::make_unique<snk::Sprite>("./Sprites/Box.png", snk::TextureFiltering::Linear, snk::TextureWrap::Clamp);
-		auto circle = std::make_unique<snk::Sprite>("./Sprites/Circle.png", snk::TextureFiltering::Linear, snk::TextureWrap::Clamp);
+		auto box = std::make_unique<snk::Sprite>("./Sprites/Box.png", snk::TextureFiltering::Linear, snk::TextureWrap::Clamp, *snk::Engine::get()->getThreadPool());
+		auto circle = std::make_unique<snk::Sprite>("./Sprites/Circle.png", snk::TextureFiltering::Linear, snk::TextureWrap::Clamp, *snk::Engine::get()->getThreadPool());
 
 		// Shaders
 		std::unique_ptr<snk::Shader> shader;
@@ -1,11 +1,13 @@
-#include <glm\gtc\type_ptr.hpp>
+#include <algorithm>
 #include "Material.hpp"
 
 namespace snk
 {
+	uint32_t Material::nextID = 0;
+
 	Material::Material(Shader* shader)
 	{
-		m_shader = shader;
+		m_layout->shader = shader;
 	}
 
 	Material::~Material()
@@ -13,47 +15,173 @@ namespace snk
 
 	}
 
-	void Material::use()
+	MaterialHandle Material::getHandle(const std::string& name) const
+	{
+		for (size_t i = 0; i < m_layout->slots.size(); i++)
+			if (m_layout->slots[i].name == name)
+				return i;
+
+		return invalidHandle;
+	}
+
+	MaterialHandle Material::findSlot(const std::string& name, UniformType type)
+	{
+		assert(m_layout->shader != nullptr);
+
+		MaterialHandle handle = getHandle(name);
+		if (handle != invalidHandle && m_layout->slots[handle].type == type)
+			return handle;
+
+		// Submitted frames may share the layout, so change a copy
+		auto layout = std::make_shared<MaterialLayout>();
+		layout->shader = m_layout->shader;
+		layout->slots = m_layout->slots;
+		m_layout = layout;
+
+		// Drop the old storage of a retyped value, so changing types back and forth can't grow the blocks
+		if (handle != invalidHandle)
+			compact(handle);
+
+		// Resolve the location once
+		if (handle == invalidHandle)
+		{
+			MaterialSlot slot = {};
+			slot.name = name;
+			const ShaderUniform* uniform = layout->shader->findUniform(name);
+			slot.location = uniform ? uniform->location : -1;
+
+			handle = layout->slots.size();
+			layout->slots.push_back(slot);
+		}
+
+		// Give the value fresh storage of the new type
+		MaterialSlot& slot = layout->slots[handle];
+		slot.type = type;
+
+		if (type == UniformType::Sprite)
+		{
+			slot.offset = m_sprites.size();
+			m_sprites.push_back(nullptr);
+		}
+		else
+		{
+			slot.offset = m_data.size();
+			m_data.resize(m_data.size() + getUniformSize(type), 0);
+		}
+
+		return handle;
+	}
+
+	void Material::compact(MaterialHandle handle)
+	{
+		auto& slots = m_layout->slots;
+
+		// Keep the other values in storage order, so the first sprite stays the main one
+		std::vector<MaterialHandle> order = {};
+		for (MaterialHandle i = 0; i < slots.size(); i++)
+			if (i != handle)
+				order.push_back(i);
+
+		std::sort(order.begin(), order.end(), [&slots](MaterialHandle a, MaterialHandle b) { return slots[a].offset < slots[b].offset; });
+
+		std::vector<float> data = {};
+		std::vector<Sprite*> sprites = {};
+		data.reserve(m_data.size());
+		sprites.reserve(m_sprites.size());
+
+		for (auto i : order)
+		{
+			MaterialSlot& slot = slots[i];
+
+			if (slot.type == UniformType::Sprite)
+			{
+				sprites.push_back(m_sprites[slot.offset]);
+				slot.offset = sprites.size() - 1;
+			}
+			else
+			{
+				size_t offset = data.size();
+				data.insert(data.end(), m_data.begin() + slot.offset, m_data.begin() + slot.offset + getUniformSize(slot.type));
+				slot.offset = offset;
+			}
+		}
+
+		m_data.swap(data);
+		m_sprites.swap(sprites);
+	}
+
+	void Material::snapshot(MaterialState& state) const
 	{
-		assert(m_shader != nullptr);
+		state.material = m_id;
+		state.layout = m_layout;
+		state.features = getFeatures();
+		state.data = m_data;
 
-		glUseProgram(m_shader->getProgram());
+		state.textures.resize(m_sprites.size());
+		for (size_t i = 0; i < m_sprites.size(); i++)
+			state.textures[i] = m_sprites[i] ? m_sprites[i]->getTexture() : 0;
+	}
 
-		// Floats
-		for (auto const& iterator : m_values_float)
-			glUniform1f(m_location_float[iterator.first], iterator.second);
 
-		// Vec2
-		for (auto const& iterator : m_values_vec2)
-			glUniform2f(m_location_vec2[iterator.first], iterator.second.x, iterator.second.y);
 
-		// Vec3
-		for (auto const& iterator : m_values_vec3)
-			glUniform3f(m_location_vec3[iterator.first], iterator.second.x, iterator.second.y, iterator.second.z);
+	void MaterialState::use(GLState& state, Shader* variant) const
+	{
+		Shader* shader = layout->shader;
+		assert(shader != nullptr);
+
+		if (variant == nullptr)
+			variant = shader;
+
+		// Everything below is already bound
+		if (!state.useMaterial(material, variant->getProgram()))
+			return;
 
-		// Vec4
-		for (auto const& iterator : m_values_vec4)
-			glUniform4f(m_location_vec4[iterator.first], iterator.second.x, iterator.second.y, iterator.second.z, iterator.second.w);
+		state.useProgram(variant->getProgram());
 
-		// Mat4
-		for (auto const& iterator : m_values_mat4)
-			glUniformMatrix4fv(m_location_mat4[iterator.first], 1, GL_FALSE, glm::value_ptr(iterator.second));
+		// Variants have their own locations, resolved the first time the layout uses them
+		const auto& slots = layout->slots;
+		const GLint* locations = nullptr;
+		if (variant != shader)
+		{
+			auto& variantLocations = layout->variantLocations[variant];
+			for (size_t i = variantLocations.size(); i < slots.size(); i++)
+			{
+				const ShaderUniform* uniform = variant->findUniform(slots[i].name);
+				variantLocations.push_back(uniform ? uniform->location : -1);
+			}
 
-		// Int
-		for (auto const& iterator : m_values_int)
-			glUniform1i(m_location_int[iterator.first], iterator.second);
+			locations = variantLocations.data();
+		}
 
-		// Texture
-		int index = 0;
+		GLuint unit = 1;
 
-		for (auto const& iterator : m_values_sprite)
+		for (size_t i = 0; i < slots.size(); i++)
 		{
-			if (index < 16)
+			const MaterialSlot& slot = slots[i];
+			GLint location = locations ? locations[i] : slot.location;
+
+			switch (slot.type)
+			{
+			case UniformType::Int:
 			{
-				glUniform1i(m_location_sprite[iterator.first], index + 1);
-				glActiveTexture(GL_TEXTURE1 + index);
-				glBindTexture(GL_TEXTURE_2D, iterator.second->getTexture());
-				index++;
+				int value = 0;
+				std::memcpy(&value, data.data() + slot.offset, sizeof(int));
+				state.setUniform(location, value);
+				break;
+			}
+
+			case UniformType::Sprite:
+				if (unit <= 16 && textures[slot.offset] != 0)
+				{
+					state.setUniform(location, static_cast<int>(unit));
+					state.bindTexture(unit, textures[slot.offset]);
+					unit++;
+				}
+				break;
+
+			default:
+				state.setUniform(location, data.data() + slot.offset, getUniformSize(slot.type));
+				break;
 			}
 		}
 	}
@@ -7,22 +7,134 @@
  */
 
 /** Includes. */
-#include <map>
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstring>
+#include <unordered_map>
 #include <glm\glm.hpp>
 #include "Sprite.hpp"
 #include "Shader.hpp"
+#include "GLState.hpp"
 
 namespace snk
 {
+	/** Handle to a value of a material. */
+	typedef size_t MaterialHandle;
+
+	/**
+	 * @enum UniformType
+	 * @brief Types of material values.
+	 */
+	enum class UniformType
+	{
+		Float = 0,
+		Int = 1,
+		Vec2 = 2,
+		Vec3 = 3,
+		Vec4 = 4,
+		Mat4 = 5,
+		Sprite = 6
+	};
+
+	/**
+	 * @brief Get the size of a uniform type in floats.
+	 * @param Uniform type.
+	 * @return Size in floats. Sprites take no space in the data block.
+	 */
+	inline size_t getUniformSize(UniformType type)
+	{
+		static const size_t sizes[] = { 1, 1, 2, 3, 4, 16, 0 };
+		return sizes[static_cast<size_t>(type)];
+	}
+
+	class Material;
+
+	/**
+	 * @struct MaterialSlot
+	 * @brief Where a value lives and where it is uploaded to.
+	 */
+	struct MaterialSlot
+	{
+		/** Value name. */
+		std::string name = "";
+
+		/** Value type. */
+		UniformType type = UniformType::Float;
+
+		/** Uniform location, from the shaders reflection. */
+		GLint location = -1;
+
+		/** Offset into the data block, in floats, or index of the sprite. */
+		size_t offset = 0;
+	};
+
+	/**
+	 * @struct MaterialLayout
+	 * @brief Shader and value slots of a material.
+	 * @note Shared with every submitted frame, so slots are never changed once created.
+	 *		 Adding or retyping a value gives the material a new layout instead.
+	 */
+	struct MaterialLayout
+	{
+		/** Shader. */
+		Shader* shader = nullptr;
+
+		/** Value slots, in upload order. */
+		std::vector<MaterialSlot> slots = {};
+
+		/** Uniform locations of every slot in each variant of the shader. Only touched by the render thread. */
+		std::unordered_map<const Shader*, std::vector<GLint>> variantLocations = {};
+	};
+
+	/**
+	 * @struct MaterialState
+	 * @brief Copy of a materials values taken when it is drawn.
+	 * @note The render thread only reads these, never the material itself.
+	 */
+	struct MaterialState
+	{
+		/** Unique ID of the material the values were copied from. */
+		uint32_t material = 0;
+
+		/** Layout at the time of the copy. */
+		std::shared_ptr<MaterialLayout> layout = nullptr;
+
+		/** Shader features the material needs. */
+		ShaderFeature features = ShaderFeature::None;
+
+		/** Every non-sprite value packed together. */
+		std::vector<float> data = {};
+
+		/** Texture of every sprite value, or 0 if unset. */
+		std::vector<GLuint> textures = {};
+
+		/**
+		 * @brief Upload the values.
+		 * @param GL state cache of the render thread.
+		 * @param Variant of the materials shader to use, or nullptr for the shader itself.
+		 * @note Used internally. Do not call.
+		 */
+		void use(GLState& state, Shader* variant = nullptr) const;
+	};
+
 	/**
 	 * @class Material
 	 * @brief Holds data to send to a shader.
+	 * @note Values are copied into the frame the first time it is drawn, so a material may be
+	 *		 changed or destroyed as soon as every draw using it has returned. Changes made after
+	 *		 that only show in the next frame. The shader and sprites it points to are not copied,
+	 *		 and must outlive the frames that drew it.
 	 * @see Shader
+	 * @see Renderer::retire
 	 */
 	class Material
 	{
 	public:
 
+		/** Handle of a value that was never set. */
+		static constexpr MaterialHandle invalidHandle = static_cast<MaterialHandle>(-1);
+
 		/**
 		 * @brief Default constructor.
 		 */
@@ -43,26 +155,17 @@ namespace snk
 		 * @brief Set a new shader for the material.
 		 * @param New shader.
 		 * @return New shader.
+		 * @note Every value and handle is discarded.
 		 */
 		inline Shader* setShader(Shader* shader)
 		{
-			m_shader = shader;
+			m_layout = std::make_shared<MaterialLayout>();
+			m_layout->shader = shader;
 
-			m_values_float.clear();
-			m_values_int.clear();
-			m_values_mat4.clear();
-			m_values_vec2.clear();
-			m_values_vec3.clear();
-			m_values_vec4.clear();
+			m_data.clear();
+			m_sprites.clear();
 
-			m_location_float.clear();
-			m_location_int.clear();
-			m_location_mat4.clear();
-			m_location_vec2.clear();
-			m_location_vec3.clear();
-			m_location_vec4.clear();
-
-			return m_shader;
+			return shader;
 		}
 
 		/**
@@ -71,152 +174,282 @@ namespace snk
 		 */
 		inline Shader* getShader() const
 		{
-			return m_shader;
+			return m_layout->shader;
+		}
+
+		/**
+		 * @brief Get the materials unique ID.
+		 * @return Unique ID.
+		 */
+		inline uint32_t getID() const
+		{
+			return m_id;
 		}
 
+		/**
+		 * @brief Get the first sprite the material samples.
+		 * @return Sprite or nullptr if the material has none.
+		 */
+		inline Sprite* getSprite() const
+		{
+			return m_sprites.empty() ? nullptr : m_sprites[0];
+		}
+
+		/**
+		 * @brief Set if fragments below half alpha are discarded.
+		 * @param If alpha testing is enabled.
+		 */
+		inline void setAlphaTest(bool alphaTest)
+		{
+			m_alphaTest = alphaTest;
+		}
+
+		/**
+		 * @brief Get if fragments below half alpha are discarded.
+		 * @return If alpha testing is enabled.
+		 */
+		inline bool getAlphaTest() const
+		{
+			return m_alphaTest;
+		}
+
+		/**
+		 * @brief Get the shader features the material needs.
+		 * @return Textured if the material samples a sprite, and AlphaTest if it is enabled.
+		 */
+		inline ShaderFeature getFeatures() const
+		{
+			ShaderFeature features = ShaderFeature::None;
+			if (getSprite())
+				features = features | ShaderFeature::Textured;
+
+			if (m_alphaTest)
+				features = features | ShaderFeature::AlphaTest;
+
+			return features;
+		}
+
+		/**
+		 * @brief Get the handle of a value.
+		 * @param Value name.
+		 * @return Handle or invalidHandle if the value was never set.
+		 */
+		MaterialHandle getHandle(const std::string& name) const;
+
 		/**
 		 * @brief Set float value.
 		 * @param Value name.
 		 * @param Value data.
+		 * @return Handle to set the value by.
 		 */
-		inline void setValue(const std::string& name, float value)
+		inline MaterialHandle setValue(const std::string& name, float value)
 		{
-			assert(m_shader != nullptr);
-			removeValue(name);
-			m_values_float[name] = value;
-			m_location_float[name] = glGetUniformLocation(m_shader->getProgram(), name.c_str());
+			MaterialHandle handle = findSlot(name, UniformType::Float);
+			setValue(handle, value);
+			return handle;
 		}
 
 		/**
 		 * @brief Set vec2 value.
 		 * @param Value name.
 		 * @param Value data.
+		 * @return Handle to set the value by.
 		 */
-		inline void setValue(const std::string& name, glm::vec2 value)
+		inline MaterialHandle setValue(const std::string& name, glm::vec2 value)
 		{
-			assert(m_shader != nullptr);
-			removeValue(name);
-			m_values_vec2[name] = value;
-			m_location_vec2[name] = glGetUniformLocation(m_shader->getProgram(), name.c_str());
+			MaterialHandle handle = findSlot(name, UniformType::Vec2);
+			setValue(handle, value);
+			return handle;
 		}
 
 		/**
 		 * @brief Set vec3 value.
 		 * @param Value name.
 		 * @param Value data.
+		 * @return Handle to set the value by.
 		 */
-		inline void setValue(const std::string& name, glm::vec3 value)
+		inline MaterialHandle setValue(const std::string& name, glm::vec3 value)
 		{
-			assert(m_shader != nullptr);
-			removeValue(name);
-			m_values_vec3[name] = value;
-			m_location_vec3[name] = glGetUniformLocation(m_shader->getProgram(), name.c_str());
+			MaterialHandle handle = findSlot(name, UniformType::Vec3);
+			setValue(handle, value);
+			return handle;
 		}
 
 		/**
 		 * @brief Set vec4 value.
 		 * @param Value name.
 		 * @param Value data.
+		 * @return Handle to set the value by.
 		 */
-		inline void setValue(const std::string& name, glm::vec4 value)
+		inline MaterialHandle setValue(const std::string& name, glm::vec4 value)
 		{
-			assert(m_shader != nullptr);
-			removeValue(name);
-			m_values_vec4[name] = value;
-			m_location_vec4[name] = glGetUniformLocation(m_shader->getProgram(), name.c_str());
+			MaterialHandle handle = findSlot(name, UniformType::Vec4);
+			setValue(handle, value);
+			return handle;
 		}
 
 		/**
 		 * @brief Set mat4 value.
 		 * @param Value name.
 		 * @param Value data.
+		 * @return Handle to set the value by.
 		 */
-		inline void setValue(const std::string& name, glm::mat4 value)
+		inline MaterialHandle setValue(const std::string& name, glm::mat4 value)
 		{
-			assert(m_shader != nullptr);
-			removeValue(name);
-			m_values_mat4[name] = value;
-			m_location_mat4[name] = glGetUniformLocation(m_shader->getProgram(), name.c_str());
+			MaterialHandle handle = findSlot(name, UniformType::Mat4);
+			setValue(handle, value);
+			return handle;
 		}
 
 		/**
 		 * @brief Set int value.
 		 * @param Value name.
 		 * @param Value data.
+		 * @return Handle to set the value by.
 		 */
-		inline void setValue(const std::string& name, int value)
+		inline MaterialHandle setValue(const std::string& name, int value)
 		{
-			assert(m_shader != nullptr);
-			removeValue(name);
-			m_values_int[name] = value;
-			m_location_int[name] = glGetUniformLocation(m_shader->getProgram(), name.c_str());
+			MaterialHandle handle = findSlot(name, UniformType::Int);
+			setValue(handle, value);
+			return handle;
 		}
 
 		/**
 		 * @brief Set sprite value.
 		 * @param Value name.
 		 * @param Value data.
+		 * @return Handle to set the value by.
 		 */
-		inline void setValue(std::string name, Sprite* value)
+		inline MaterialHandle setValue(const std::string& name, Sprite* value)
 		{
-			assert(m_shader != nullptr);
-			removeValue(name);
-			m_values_sprite[name] = value;
-			m_location_sprite[name] = glGetUniformLocation(m_shader->getProgram(), name.c_str());
+			MaterialHandle handle = findSlot(name, UniformType::Sprite);
+			setValue(handle, value);
+			return handle;
 		}
 
 		/**
-		 * @brief Use the material.
-		 * @note Used internally. Do not call.
+		 * @brief Set float value.
+		 * @param Value handle.
+		 * @param Value data.
+		 */
+		inline void setValue(MaterialHandle handle, float value)
+		{
+			writeValue(handle, UniformType::Float, &value);
+		}
+
+		/**
+		 * @brief Set vec2 value.
+		 * @param Value handle.
+		 * @param Value data.
+		 */
+		inline void setValue(MaterialHandle handle, glm::vec2 value)
+		{
+			writeValue(handle, UniformType::Vec2, &value[0]);
+		}
+
+		/**
+		 * @brief Set vec3 value.
+		 * @param Value handle.
+		 * @param Value data.
+		 */
+		inline void setValue(MaterialHandle handle, glm::vec3 value)
+		{
+			writeValue(handle, UniformType::Vec3, &value[0]);
+		}
+
+		/**
+		 * @brief Set vec4 value.
+		 * @param Value handle.
+		 * @param Value data.
+		 */
+		inline void setValue(MaterialHandle handle, glm::vec4 value)
+		{
+			writeValue(handle, UniformType::Vec4, &value[0]);
+		}
+
+		/**
+		 * @brief Set mat4 value.
+		 * @param Value handle.
+		 * @param Value data.
+		 */
+		inline void setValue(MaterialHandle handle, glm::mat4 value)
+		{
+			writeValue(handle, UniformType::Mat4, &value[0][0]);
+		}
+
+		/**
+		 * @brief Set int value.
+		 * @param Value handle.
+		 * @param Value data.
+		 */
+		inline void setValue(MaterialHandle handle, int value)
+		{
+			writeValue(handle, UniformType::Int, &value);
+		}
+
+		/**
+		 * @brief Set sprite value.
+		 * @param Value handle.
+		 * @param Value data.
 		 */
-		void use();
+		inline void setValue(MaterialHandle handle, Sprite* value)
+		{
+			assert(handle < m_layout->slots.size() && m_layout->slots[handle].type == UniformType::Sprite);
+			m_sprites[m_layout->slots[handle].offset] = value;
+		}
+
+		/**
+		 * @brief Copy everything the render thread needs.
+		 * @param State to copy into.
+		 * @note Used internally when the material is drawn. Do not call.
+		 */
+		void snapshot(MaterialState& state) const;
 
 	private:
 
-		/** Shader the material uses. */
-		Shader* m_shader;
-
-		/**
-		 * @brief Removes a value from every uniform list by name.
-		 * @param Name of the value to remove.
-		 */
-		inline void removeValue(const std::string& name)
-		{
-			// Remove from values
-			m_values_float.erase(name);
-			m_values_vec2.erase(name);
-			m_values_vec3.erase(name);
-			m_values_vec4.erase(name);
-			m_values_mat4.erase(name);
-			m_values_int.erase(name);
-			m_values_sprite.erase(name);
-
-			// Remove from location
-			m_location_float.erase(name);
-			m_location_vec2.erase(name);
-			m_location_vec3.erase(name);
-			m_location_vec4.erase(name);
-			m_location_mat4.erase(name);
-			m_location_int.erase(name);
-			m_location_sprite.erase(name);
-		}
-
-		/** Values. */
-		std::map<std::string, float> m_values_float = {};
-		std::map<std::string, glm::vec2> m_values_vec2 = {};
-		std::map<std::string, glm::vec3> m_values_vec3 = {};
-		std::map<std::string, glm::vec4> m_values_vec4 = {};
-		std::map<std::string, glm::mat4> m_values_mat4 = {};
-		std::map<std::string, int> m_values_int = {};
-		std::map<std::string, Sprite*> m_values_sprite = {};
-
-		/** Locations. */
-		std::map<std::string, uint32_t> m_location_float = {};
-		std::map<std::string, uint32_t> m_location_vec2 = {};
-		std::map<std::string, uint32_t> m_location_vec3 = {};
-		std::map<std::string, uint32_t> m_location_vec4 = {};
-		std::map<std::string, uint32_t> m_location_mat4 = {};
-		std::map<std::string, uint32_t> m_location_int = {};
-		std::map<std::string, uint32_t> m_location_sprite = {};
+		/**
+		 * @brief Find the slot of a value, creating or retyping it if needed.
+		 * @param Value name.
+		 * @param Value type.
+		 * @return Handle of the slot.
+		 */
+		MaterialHandle findSlot(const std::string& name, UniformType type);
+
+		/**
+		 * @brief Repack the data block and sprites without the storage of a value.
+		 * @param Handle of the value whose storage is dropped.
+		 * @note Only call on a layout no submitted frame shares, since offsets change.
+		 */
+		void compact(MaterialHandle handle);
+
+		/**
+		 * @brief Copy a value into the data block.
+		 * @param Value handle.
+		 * @param Value type.
+		 * @param Value data.
+		 */
+		inline void writeValue(MaterialHandle handle, UniformType type, const void* value)
+		{
+			assert(handle < m_layout->slots.size() && m_layout->slots[handle].type == type);
+			std::memcpy(&m_data[m_layout->slots[handle].offset], value, getUniformSize(type) * sizeof(float));
+		}
+
+		/** Next materials unique ID. */
+		static uint32_t nextID;
+
+		/** Unique ID. */
+		uint32_t m_id = nextID++;
+
+		/** Shader and value slots. */
+		std::shared_ptr<MaterialLayout> m_layout = std::make_shared<MaterialLayout>();
+
+		/** Every non-sprite value packed together. Ints are stored bit for bit. */
+		std::vector<float> m_data = {};
+
+		/** Sprite values. */
+		std::vector<Sprite*> m_sprites = {};
+
+		/** Are fragments below half alpha discarded? */
+		bool m_alphaTest = false;
 	};
 }
\ No newline at end of file
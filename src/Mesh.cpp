@@ -27,6 +27,7 @@ namespace snk
 		// Cleanup
 		glDeleteBuffers(1, &m_vbo);
 		glDeleteBuffers(1, &m_ebo);
+		glDeleteBuffers(1, &m_instanceVbo);
 		glDeleteVertexArrays(1, &m_vao);
 	}
 
@@ -64,6 +65,21 @@ namespace snk
 		glEnableVertexAttribArray(0);
 		glEnableVertexAttribArray(1);
 
+		// Per instance model basis, translation, and color
+		glGenBuffers(1, &m_instanceVbo);
+		glBindBuffer(GL_ARRAY_BUFFER, m_instanceVbo);
+
+		const GLint sizes[] = { 4, 3, 4 };
+		size_t offset = 0;
+
+		for (GLuint i = 0; i < 3; i++)
+		{
+			glVertexAttribPointer(2 + i, sizes[i], GL_FLOAT, GL_FALSE, 11 * sizeof(float), (GLvoid*)(offset * sizeof(float)));
+			glVertexAttribDivisor(2 + i, 1);
+			glEnableVertexAttribArray(2 + i);
+			offset += sizes[i];
+		}
+
 		// Unbind our VAO
 		glBindVertexArray(0);
 	}
@@ -55,6 +55,33 @@ namespace snk
 			return m_indices.size();
 		}
 
+		/**
+		 * @brief Get vertices.
+		 * @return Vertices.
+		 */
+		inline const std::vector<glm::vec2>& getVertices() const
+		{
+			return m_vertices;
+		}
+
+		/**
+		 * @brief Get UVs.
+		 * @return UVs.
+		 */
+		inline const std::vector<glm::vec2>& getUVs() const
+		{
+			return m_uvs;
+		}
+
+		/**
+		 * @brief Get indices.
+		 * @return Indices.
+		 */
+		inline const std::vector<uint32_t>& getIndices() const
+		{
+			return m_indices;
+		}
+
 		/**
 		 * @brief Get vertex attribute object.
 		 * @return Vertex attribute object.
@@ -64,6 +91,16 @@ namespace snk
 			return m_vao;
 		}
 
+		/**
+		 * @brief Get instance buffer object.
+		 * @return Instance buffer object.
+		 * @note Holds a model transformation and color per instance for instanced shaders.
+		 */
+		inline GLuint getInstanceVBO() const
+		{
+			return m_instanceVbo;
+		}
+
 	private:
 
 		/**
@@ -84,6 +121,9 @@ namespace snk
 		/** Element buffer object. */
 		GLuint m_ebo = 0;
 
+		/** Instance buffer object. */
+		GLuint m_instanceVbo = 0;
+
 		/** Vertices. */
 		std::vector<glm::vec2> m_vertices = {};
 
@@ -0,0 +1,150 @@
+#pragma once
+
+/**
+ * @file Query.hpp
+ * @brief Query header file.
+ * @author Connor J. Bramham (ReeCocho)
+ */
+
+/** Includes. */
+#include <tuple>
+#include <vector>
+#include <algorithm>
+#include "ComponentPool.hpp"
+
+namespace snk
+{
+	/**
+	 * @struct Archetype
+	 * @brief A set of component types whose pools are kept packed in lockstep.
+	 * @note The first "size" components of every pool in the archetype belong to the
+	 *		 entities that have every type in the set, stored in the same order.
+	 */
+	struct Archetype
+	{
+		/** Component IDs in the archetype. */
+		std::vector<ComponentID> ids = {};
+
+		/** Pools owned by the archetype, in the same order as the IDs. */
+		std::vector<IComponentPool*> pools = {};
+
+		/** Number of entities packed at the front of every pool. */
+		size_t size = 0;
+	};
+
+	/**
+	 * @class Query
+	 * @brief Iterates every entity that has all of the given component types.
+	 * @note Only the exact types are matched, polymorphic children are not.
+	 * @see Scene
+	 */
+	template<class... ComponentTypes>
+	class Query
+	{
+	public:
+
+		/**
+		 * @brief Constructor.
+		 * @param Pools of every component type, nullptr if a type has none.
+		 * @param Archetype made of exactly the component types, or nullptr.
+		 */
+		Query(std::tuple<ComponentPool<ComponentTypes>*...> pools, const Archetype* archetype) : m_pools(pools), m_archetype(archetype)
+		{
+
+		}
+
+		/**
+		 * @brief Run a function on every matching entity.
+		 * @param Function taking a reference to each component type.
+		 * @note Don't add or remove components of the queried types while iterating.
+		 */
+		template<class Function>
+		void each(Function function)
+		{
+			// Bail if any type has no components at all
+			bool empty = false;
+			int expand[] = { (empty = empty || std::get<ComponentPool<ComponentTypes>*>(m_pools) == nullptr, 0)... };
+			(void)expand;
+
+			if (empty)
+				return;
+
+			// Archetypes store matching entities at the same index in every pool
+			if (m_archetype)
+			{
+				for (size_t i = 0; i < m_archetype->size; i++)
+					function(*std::get<ComponentPool<ComponentTypes>*>(m_pools)->slot(i)...);
+
+				return;
+			}
+
+			// Otherwise walk the smallest pool and look the rest up
+			IComponentPool* smallest = nullptr;
+			int find[] = { (smallest = (smallest == nullptr || std::get<ComponentPool<ComponentTypes>*>(m_pools)->size() < smallest->size()) ? std::get<ComponentPool<ComponentTypes>*>(m_pools) : smallest, 0)... };
+			(void)find;
+
+			for (size_t i = 0; i < smallest->size(); i++)
+			{
+				size_t entity = smallest->getEntity(i);
+
+				bool matches = true;
+				int check[] = { (matches = matches && std::get<ComponentPool<ComponentTypes>*>(m_pools)->contains(entity), 0)... };
+				(void)check;
+
+				if (matches)
+					function(*std::get<ComponentPool<ComponentTypes>*>(m_pools)->slot(std::get<ComponentPool<ComponentTypes>*>(m_pools)->indexOf(entity))...);
+			}
+		}
+
+		/**
+		 * @brief Run a function on contiguous arrays of matching components.
+		 * @param Function taking a count followed by a pointer to an array of each component type.
+		 * @note Arrays are as long as a pool page when querying a single type or an archetype.
+		 *		 Any other query falls back to arrays of one component.
+		 */
+		template<class Function>
+		void chunks(Function function)
+		{
+			bool empty = false;
+			int expand[] = { (empty = empty || std::get<ComponentPool<ComponentTypes>*>(m_pools) == nullptr, 0)... };
+			(void)expand;
+
+			if (empty)
+				return;
+
+			// Packed components line up page by page in every pool
+			if (m_archetype || sizeof...(ComponentTypes) == 1)
+			{
+				size_t count = m_archetype ? m_archetype->size : std::get<0>(m_pools)->size();
+				size_t pageSize = std::get<0>(m_pools)->pageSize;
+
+				for (size_t i = 0; i < count; i += pageSize - (i % pageSize))
+				{
+					size_t length = std::min(pageSize - (i % pageSize), count - i);
+					function(length, std::get<ComponentPool<ComponentTypes>*>(m_pools)->slot(i)...);
+				}
+
+				return;
+			}
+
+			each([&function](ComponentTypes&... components) { function(static_cast<size_t>(1), &components...); });
+		}
+
+		/**
+		 * @brief Get if the query iterates an archetype.
+		 * @return If the query iterates an archetype.
+		 */
+		inline bool isPacked() const
+		{
+			return m_archetype != nullptr;
+		}
+
+	private:
+
+		/** Pools of every component type. */
+		std::tuple<ComponentPool<ComponentTypes>*...> m_pools;
+
+		/** Archetype made of exactly the component types. */
+		const Archetype* m_archetype = nullptr;
+	};
+}
\ No newline at end of file
@@ -1,11 +1,12 @@
-#include <glm\gtc\type_ptr.hpp>
+#include <algorithm>
 #include "Renderer.hpp"
+#include "Utilities.hpp"
 
 namespace snk
 {
-	Renderer::Renderer(Graphics* graphics) : m_graphics(graphics)
+	Renderer::Renderer(Graphics* graphics, size_t maxFramesInFlight) : m_graphics(graphics), m_maxFramesInFlight(std::max(maxFramesInFlight, static_cast<size_t>(1)))
 	{
-
+		m_packets.resize(m_maxFramesInFlight + 1);
 	}
 
 	Renderer::~Renderer()
@@ -13,17 +14,98 @@ namespace snk
 
 	}
 
-	void Renderer::render()
+	void Renderer::release()
+	{
+		m_graphics->bindRenderContext();
+
+		// Packets that were never rendered may still hold retired objects
+		for (auto& packet : m_packets)
+			destroyRetired(packet);
+
+		glDeleteBuffers(1, &m_cameraUbo);
+		m_cameraUbo = 0;
+		m_spriteBatch = nullptr;
+	}
+
+	void Renderer::destroyRetired(RenderPacket& packet)
 	{
+		// GL may hand the IDs to new programs, so drop their cached uniforms
+		m_retiredPrograms.clear();
+		for (const auto& shader : packet.retiredShaders)
+			shader->getPrograms(m_retiredPrograms);
+
+		for (auto program : m_retiredPrograms)
+			m_state.forgetProgram(program);
+
+		packet.retiredShaders.clear();
+		packet.retired.clear();
+	}
+
+	void Renderer::draw(const MeshData& mesh)
+	{
+		uint64_t key = makeSortKey(mesh);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		RenderPacket& recorded = m_packets[m_recordPacket];
+
+		// Copy every material once, so the render thread never reads them
+		auto found = m_materialIndices.find(mesh.material->getID());
+		if (found == m_materialIndices.end())
+		{
+			found = m_materialIndices.emplace(mesh.material->getID(), static_cast<uint32_t>(recorded.materials.size())).first;
+			recorded.materials.emplace_back();
+			mesh.material->snapshot(recorded.materials.back());
+		}
+
+		recorded.meshes.push_back(mesh);
+		recorded.keys.push_back(key);
+		recorded.materialIndices.push_back(found->second);
+	}
+
+	size_t Renderer::submit(float time)
+	{
+		// The next packet is free once fewer than the maximum frames are in flight
+		{
+			std::unique_lock<std::mutex> lock(m_framesMutex);
+			m_framesCondition.wait(lock, [this]() { return m_framesInFlight < m_maxFramesInFlight; });
+			m_framesInFlight++;
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		size_t packet = m_recordPacket;
+		RenderPacket& recorded = m_packets[packet];
+		recorded.time = time;
+
+		// Materials are copied again by the first draw of the next packet
+		m_materialIndices.clear();
+		m_recordPacket = (m_recordPacket + 1) % m_packets.size();
+
+		return packet;
+	}
+
+	void Renderer::render(size_t packet)
+	{
+		const auto& meshes = m_packets[packet].meshes;
+		const auto& materials = m_packets[packet].materials;
+		const auto& materialIndices = m_packets[packet].materialIndices;
+		const auto& cameras = m_packets[packet].cameras;
+
 		// Bind contex to the current thread
 		m_graphics->bindRenderContext();
 
+		// Upload sprites decoded since the last frame
+		Sprite::uploadPending();
+
+		// Other threads may have bound state since the last frame
+		m_state.invalidate();
+		m_state.resetCounters();
+
 		// Clear screen
 		m_graphics->clearScreen();
-		
+
 		// Find the main camera.
 		CameraData mainCamera = {};
-		for (const auto& camera : m_cameras)
+		for (const auto& camera : cameras)
 			if (camera.mainCamera)
 			{
 				mainCamera = camera;
@@ -31,32 +113,120 @@ namespace snk
 			}
 
 		// Make sure it's the main camera
-		if (!mainCamera.mainCamera)
-			return;
+		if (mainCamera.mainCamera)
+		{
+			// Upload the camera once for every draw
+			CameraUniforms uniforms = {};
+			uniforms.view = mainCamera.view;
+			uniforms.projection = mainCamera.projection;
+			uniforms.viewProjection = mainCamera.projection * mainCamera.view;
+			uniforms.time = glm::vec4(m_packets[packet].time, 0, 0, 0);
 
-		// Calculate VP matrix
-		glm::mat4 VP = mainCamera.projection * mainCamera.view;
+			if (m_cameraUbo == 0)
+				glGenBuffers(1, &m_cameraUbo);
 
-		// Render every mesh
-		for (size_t i = 0; i < m_meshes.size(); i++)
-		{
-			size_t index = (m_meshes.size() - i) - 1;
-			
-			m_meshes[index].material->use();
-			
-			// Set MVP matrix
-			GLint mvp = glGetUniformLocation(m_meshes[index].material->getShader()->getProgram(), "MVP");
-			glUniformMatrix4fv(mvp, 1, GL_FALSE, glm::value_ptr(VP * m_meshes[index].model));
-
-			glBindVertexArray(m_meshes[index].mesh->getVAO());
-			glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_meshes[index].mesh->getIndexCount()), GL_UNSIGNED_INT, 0);
+			glBindBuffer(GL_UNIFORM_BUFFER, m_cameraUbo);
+			glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraUniforms), &uniforms, GL_STREAM_DRAW);
+			glBindBufferBase(GL_UNIFORM_BUFFER, Shader::cameraBinding, m_cameraUbo);
+
+			// Sort once, lowest depth first
+			const auto& keys = m_packets[packet].keys;
+			radixSort(keys.data(), keys.size(), m_drawOrder, m_sortScratch);
+
+			if (!m_spriteBatch)
+				m_spriteBatch = std::make_unique<SpriteBatch>(&m_state);
+
+			m_spriteBatch->begin();
+
+			// Render every mesh
+			for (size_t i = 0; i < m_drawOrder.size();)
+			{
+				const MeshData& mesh = meshes[m_drawOrder[i]];
+				const MaterialState& material = materials[materialIndices[m_drawOrder[i]]];
+				Shader* shader = material.layout->shader;
+
+				// Find every following draw with the same mesh and material
+				size_t end = i + 1;
+				while (end < m_drawOrder.size() && meshes[m_drawOrder[end]].mesh == mesh.mesh && materialIndices[m_drawOrder[end]] == materialIndices[m_drawOrder[i]])
+					end++;
+
+				bool instancing = hasFeature(shader->getSupportedFeatures(), ShaderFeature::Instanced);
+
+				// Long runs of one mesh are instanced, short or mixed runs of small meshes are merged on the CPU
+				if (SpriteBatch::canBatch(mesh, material) && !(instancing && end - i >= minInstancedRun))
+				{
+					for (; i < end; i++)
+						m_spriteBatch->add(meshes[m_drawOrder[i]], material);
+
+					continue;
+				}
+
+				// Keep draw order by drawing the batch first
+				m_spriteBatch->flush();
+
+				bool instanced = end - i > 1 && instancing;
+
+				Shader* variant = shader->getVariant(instanced ? material.features | ShaderFeature::Instanced : material.features);
+				material.use(m_state, variant);
+				m_state.bindVertexArray(mesh.mesh->getVAO());
+
+				if (instanced)
+				{
+					m_instances.clear();
+					for (; i < end; i++)
+					{
+						const MeshData& instance = meshes[m_drawOrder[i]];
+
+						InstanceData data = {};
+						data.model = instance.model;
+						data.color = instance.color;
+						m_instances.push_back(data);
+					}
+
+					// Orphan the old instance data so the driver doesn't wait on it
+					glBindBuffer(GL_ARRAY_BUFFER, mesh.mesh->getInstanceVBO());
+					glBufferData(GL_ARRAY_BUFFER, m_instances.size() * sizeof(InstanceData), nullptr, GL_STREAM_DRAW);
+					glBufferSubData(GL_ARRAY_BUFFER, 0, m_instances.size() * sizeof(InstanceData), m_instances.data());
+
+					glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(mesh.mesh->getIndexCount()), GL_UNSIGNED_INT, 0, static_cast<GLsizei>(m_instances.size()));
+				}
+				else
+				{
+					for (; i < end; i++)
+					{
+						const MeshData& draw = meshes[m_drawOrder[i]];
+
+						// Set model transformation and tint
+						m_state.setUniform(variant->getModelBasisLocation(), draw.model.basis);
+						m_state.setUniform(variant->getModelTranslationLocation(), draw.model.translation);
+						m_state.setUniform(variant->getTintLocation(), draw.color);
+
+						glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(mesh.mesh->getIndexCount()), GL_UNSIGNED_INT, 0);
+					}
+				}
+			}
+
+			m_spriteBatch->flush();
+
+			// Swap old screen with new screen
+			m_graphics->swapBuffers();
 		}
 
-		// Swap old screen with new screen
-		m_graphics->swapBuffers();
+		// Clear the packet so it can be recorded into again
+		m_packets[packet].meshes.clear();
+		m_packets[packet].keys.clear();
+		m_packets[packet].materials.clear();
+		m_packets[packet].materialIndices.clear();
+		m_packets[packet].cameras.clear();
 
-		// Clear queued meshes
-		m_meshes.clear();
-		m_cameras.clear();
+		// Every earlier packet is rendered too, so nothing can draw these anymore
+		destroyRetired(m_packets[packet]);
+
+		{
+			std::lock_guard<std::mutex> lock(m_framesMutex);
+			m_stateCounters = m_state.getCounters();
+			m_framesInFlight--;
+			m_framesCondition.notify_all();
+		}
 	}
 }
\ No newline at end of file
@@ -7,9 +7,16 @@
  */
 
 /** Includes. */
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <condition_variable>
+#include "Affine.hpp"
 #include "Graphics.hpp"
 #include "Material.hpp"
 #include "Mesh.hpp"
+#include "SpriteBatch.hpp"
 
 namespace snk
 {
@@ -19,19 +26,38 @@ namespace snk
 	 */
 	struct MeshData
 	{
-		/** Mesh. */
+		/** Mesh. Must outlive the frame. */
 		Mesh* mesh = nullptr;
 
-		/** Material. */
+		/** Material. Its values are copied when the mesh is drawn. */
 		Material* material = nullptr;
 
-		/** Model matrix. */
-		glm::mat4 model = {};
+		/** Model transformation. */
+		Affine model = {};
 
 		/** Mesh depth. */
 		uint32_t depth = 0;
+
+		/** Color to tint the mesh with. */
+		glm::vec4 color = glm::vec4(1, 1, 1, 1);
+	};
+
+	/**
+	 * @struct InstanceData
+	 * @brief Per instance data read by instanced shaders.
+	 * @note Uploaded as 11 tightly packed floats.
+	 */
+	struct InstanceData
+	{
+		/** Model transformation. */
+		Affine model = {};
+
+		/** Color. */
+		glm::vec4 color = {};
 	};
 
+	static_assert(sizeof(InstanceData) == 11 * sizeof(float), "InstanceData must match the instance attribute layout.");
+
 	/**
 	 * @struct CameraData
 	 * @brief Holds data about a camera to render with.
@@ -48,14 +74,74 @@ namespace snk
 		bool mainCamera = false;
 	};
 
+	/**
+	 * @struct CameraUniforms
+	 * @brief Contents of the Camera uniform block, laid out for std140.
+	 */
+	struct CameraUniforms
+	{
+		/** View matrix. */
+		glm::mat4 view = {};
+
+		/** Projection matrix. */
+		glm::mat4 projection = {};
+
+		/** Projection times view. */
+		glm::mat4 viewProjection = {};
+
+		/** Seconds since the engine started, followed by padding. */
+		glm::vec4 time = {};
+	};
+
+	/**
+	 * @struct RenderPacket
+	 * @brief Everything submitted for drawing during one frame.
+	 */
+	struct RenderPacket
+	{
+		/** Meshes to render, in the order they were drawn. */
+		std::vector<MeshData> meshes = {};
+
+		/** Sort key of every mesh. */
+		std::vector<uint64_t> keys = {};
+
+		/** Values of every material drawn, copied the first time each is drawn. */
+		std::vector<MaterialState> materials = {};
+
+		/** Index into materials of every mesh. */
+		std::vector<uint32_t> materialIndices = {};
+
+		/** Objects to destroy once the packet is rendered. */
+		std::vector<std::shared_ptr<void>> retired = {};
+
+		/** Shaders to destroy once the packet is rendered, after their programs are forgotten. */
+		std::vector<std::unique_ptr<Shader>> retiredShaders = {};
+
+		/** Cameras to render with. */
+		std::vector<CameraData> cameras = {};
+
+		/** Seconds since the engine started. */
+		float time = 0;
+	};
+
 	/**
 	 * @class Renderer
 	 * @brief Rendering engine.
+	 * @note Draws are recorded into a packet while the scene ticks. Submitting a packet hands it
+	 *		 to the render thread and starts recording the next one, so the scene can simulate
+	 *		 a frame while the previous one is being rendered.
+	 *		 The render thread never reads a material. Their values are copied into the packet when
+	 *		 first drawn, so materials may be changed or destroyed once draw() returns. Meshes, shaders, and
+	 *		 sprites are read by the render thread, so they must outlive every frame in flight
+	 *		 that drew them: hand them to retire(), or destroy them while the render thread is idle.
 	 */
 	class Renderer
 	{
 	public:
 
+		/** Shortest run of one batchable mesh and material that is instanced instead of batched. */
+		static constexpr size_t minInstancedRun = 16;
+
 		/**
 		 * @brief Default constructor.
 		 */
@@ -64,8 +150,9 @@ namespace snk
 		/**
 		 * @brief Constructor.
 		 * @param Graphics context.
+		 * @param Maximum number of submitted frames waiting on or being rendered.
 		 */
-		Renderer(Graphics* graphics);
+		Renderer(Graphics* graphics, size_t maxFramesInFlight = 1);
 
 		/**
 		 * @brief Destructor.
@@ -82,45 +169,163 @@ namespace snk
 		}
 
 		/**
-		 * @brief Render everything to the screen.
+		 * @brief Get the maximum number of frames in flight.
+		 * @return Maximum number of frames in flight.
+		 */
+		inline size_t getMaxFramesInFlight() const
+		{
+			return m_maxFramesInFlight;
+		}
+
+		/**
+		 * @brief Get how many GL state changes the last rendered frame issued and skipped.
+		 * @return State counters.
+		 */
+		inline GLStateCounters getStateCounters()
+		{
+			std::lock_guard<std::mutex> lock(m_framesMutex);
+			return m_stateCounters;
+		}
+
+		/**
+		 * @brief Finish recording the current packet and start recording the next one.
+		 * @param Seconds since the engine started.
+		 * @return Index of the finished packet to pass to render().
+		 * @note Blocks while the maximum number of frames are in flight.
+		 */
+		size_t submit(float time);
+
+		/**
+		 * @brief Render a submitted packet to the screen.
+		 * @param Packet index.
+		 * @note Must be called in the order packets were submitted.
 		 */
-		void render();
+		void render(size_t packet);
+
+		/**
+		 * @brief Delete the GL objects the renderer created.
+		 * @note Must run on the render thread after the last packet, before the renderer is destroyed.
+		 */
+		void release();
 
 		/**
 		 * @brief Draw a mesh.
 		 * @param Mesh to draw.
+		 * @note Thread safe, as long as nothing changes the material while it is drawn. Meshes are
+		 *		 drawn in order of ascending depth, then grouped by state.
+		 */
+		void draw(const MeshData& mesh);
+
+		/**
+		 * @brief Destroy an object once every frame that may have drawn it is rendered.
+		 * @param Object, such as a mesh, shader, or sprite.
+		 * @note Thread safe. The object is destroyed on the render thread, after the packet being
+		 *		 recorded, since packets render in order.
+		 */
+		template<class T>
+		inline void retire(std::unique_ptr<T> object)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_packets[m_recordPacket].retired.push_back(std::shared_ptr<void>(std::move(object)));
+		}
+
+		/**
+		 * @brief Destroy a shader once every frame that may have drawn it is rendered.
+		 * @param Shader.
+		 * @note Thread safe. The render thread also forgets the cached uniforms of the shader and its variants.
 		 */
-		inline void draw(const MeshData& mesh)
+		inline void retire(std::unique_ptr<Shader> shader)
 		{
-			if(m_meshes.size() == 0)
-				m_meshes.push_back(mesh);
-
-			for (size_t i = 0; i < m_meshes.size(); i++)
-				if (m_meshes[i].depth <= mesh.depth || i == m_meshes.size() - 1)
-				{
-					m_meshes.insert(m_meshes.begin() + i, mesh);
-					return;
-				}
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_packets[m_recordPacket].retiredShaders.push_back(std::move(shader));
 		}
 
 		/**
 		 * @brief Draw to a camera.
 		 * @param Camera to draw to.
+		 * @note Thread safe.
 		 */
 		inline void drawTo(const CameraData& camera)
 		{
-			m_cameras.push_back(camera);
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_packets[m_recordPacket].cameras.push_back(camera);
 		}
 
 	private:
 
+		/**
+		 * @brief Destroy the objects retired into a packet.
+		 * @param Packet.
+		 * @note Render thread only.
+		 */
+		void destroyRetired(RenderPacket& packet);
+
+		/**
+		 * @brief Build the key meshes are sorted by before rendering.
+		 * @param Mesh.
+		 * @return Depth in the high 32 bits, followed by a byte each of the shader, material, texture, and mesh.
+		 */
+		static inline uint64_t makeSortKey(const MeshData& mesh)
+		{
+			Sprite* sprite = mesh.material->getSprite();
+
+			return
+				(static_cast<uint64_t>(mesh.depth) << 32) |
+				(static_cast<uint64_t>(mesh.material->getShader()->getProgram() & 0xFF) << 24) |
+				(static_cast<uint64_t>(mesh.material->getID() & 0xFF) << 16) |
+				(static_cast<uint64_t>((sprite ? sprite->getTexture() : 0) & 0xFF) << 8) |
+				static_cast<uint64_t>(mesh.mesh->getVAO() & 0xFF);
+		}
+
 		/** Graphics context. */
 		Graphics* m_graphics;
 
-		/** Lists of meshes to render. */
-		std::vector<MeshData> m_meshes = {};
+		/** Packets. One more than the maximum number of frames in flight. */
+		std::vector<RenderPacket> m_packets = {};
+
+		/** Mesh indices of the packet being rendered in draw order. */
+		std::vector<uint32_t> m_drawOrder = {};
+
+		/** Scratch buffer for sorting. */
+		std::vector<uint32_t> m_sortScratch = {};
+
+		/** Index of every material in the packet being recorded, by ID, since addresses may be reused within a frame. */
+		std::unordered_map<uint32_t, uint32_t> m_materialIndices = {};
+
+		/** Programs of the shaders being destroyed. */
+		std::vector<GLuint> m_retiredPrograms = {};
+
+		/** Instance data of the batch being rendered. */
+		std::vector<InstanceData> m_instances = {};
+
+		/** Uniform buffer holding the Camera block. Created on the render thread. */
+		GLuint m_cameraUbo = 0;
+
+		/** GL state cache of the render thread. */
+		GLState m_state = {};
+
+		/** State counters of the last rendered frame. */
+		GLStateCounters m_stateCounters = {};
+
+		/** Batches small meshes whose shaders have a batched variant. Created on the render thread. */
+		std::unique_ptr<SpriteBatch> m_spriteBatch = nullptr;
+
+		/** Packet being recorded. */
+		size_t m_recordPacket = 0;
+
+		/** Guards the packet being recorded so systems can draw in parallel. */
+		std::mutex m_mutex;
+
+		/** Maximum number of frames in flight. */
+		size_t m_maxFramesInFlight = 1;
+
+		/** Number of submitted packets not rendered yet. */
+		size_t m_framesInFlight = 0;
+
+		/** Frames in flight mutex. */
+		std::mutex m_framesMutex;
 
-		/** List of cameras to render with. */
-		std::vector<CameraData> m_cameras = {};
+		/** Signaled when a frame finishes rendering. */
+		std::condition_variable m_framesCondition;
 	};
 }
\ No newline at end of file
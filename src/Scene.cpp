@@ -1,22 +1,26 @@
+#include <algorithm>
 #include "Transform.hpp"
 #include "Component.hpp"
 #include "Scene.hpp"
+#include "ThreadPool.hpp"
 
 namespace snk
 {
 	Scene::Scene()
 	{
-		// Resize component array to fit every component
-		m_components.resize(Component::getRegisteredComponentCount());
+		// Resize pool array to fit every component
+		m_pools.resize(Component::getRegisteredComponentCount());
 	}
 
 	Scene::~Scene()
 	{
 		// Run onEnd()
-		for (auto& componentList : m_components)
-			for (auto& component : componentList)
-				if (component->getRunOnEnd())
-					component->onEnd();
+		for (auto& pool : m_pools)
+			if (pool)
+				pool->end();
+
+		// Free components before anything they reference
+		m_pools.clear();
 	}
 
 	void Scene::tick(float deltaTime)
@@ -25,41 +29,108 @@ namespace snk
 		destroyMarkedComponents();
 
 		// Run onTick()
-		for (auto& componentList : m_components)
-			for (auto& component : componentList)
-				if (component->getRunOnTick())
-					component->onTick(deltaTime);
+		for (auto id : m_tickPools)
+			m_pools[id]->tick(deltaTime);
+
+		runSystems(SystemPhase::Tick, deltaTime);
 
 		// Run onLateTick()
-		for (auto& componentList : m_components)
-			for (auto& component : componentList)
-				if (component->getRunOnLateTick())
-					component->onLateTick(deltaTime);
+		for (auto id : m_lateTickPools)
+			m_pools[id]->lateTick(deltaTime);
+
+		runSystems(SystemPhase::LateTick, deltaTime);
 
 		// Run onPreRender()
-		for (auto& componentList : m_components)
-			for (auto& component : componentList)
-				if (component->getRunOnPreRender())
-					component->onPreRender(deltaTime);
+		for (auto id : m_preRenderPools)
+			m_pools[id]->preRender(deltaTime);
+
+		runSystems(SystemPhase::PreRender, deltaTime);
+	}
+
+	void Scene::setLocalPositions(const EntityHandle* entities, const glm::vec3* positions, size_t count)
+	{
+		forEachTransform(entities, count, [positions](Transform& transform, size_t i) { transform.setLocalPosition(positions[i]); });
+	}
+
+	void Scene::setLocalRotations(const EntityHandle* entities, const float* rotations, size_t count)
+	{
+		forEachTransform(entities, count, [rotations](Transform& transform, size_t i) { transform.setLocalRotation(rotations[i]); });
+	}
+
+	void Scene::setLocalScales(const EntityHandle* entities, const glm::vec2* scales, size_t count)
+	{
+		forEachTransform(entities, count, [scales](Transform& transform, size_t i) { transform.setLocalScale(scales[i]); });
 	}
 
-	size_t Scene::create()
+	template<class Function>
+	void Scene::forEachTransform(const EntityHandle* entities, size_t count, Function function)
 	{
-		if (m_emptyHandles.size() > 0)
+		auto run = [this, entities, &function](size_t begin, size_t end)
 		{
-			size_t handle = m_emptyHandles[0];
-			m_emptyHandles.erase(m_emptyHandles.begin());
-			addComponent<snk::Transform>(handle);
-			return handle;
+			for (size_t i = begin; i < end; i++)
+				if (Transform* transform = getComponent<Transform>(entities[i]))
+					function(*transform, i);
+		};
+
+		if (m_threadPool == nullptr || count <= TransformHierarchy::grainSize)
+			run(0, count);
+		else
+			m_threadPool->parallelFor(0, count, TransformHierarchy::grainSize, run);
+	}
+
+	void Scene::addSystem(SystemPhase phase, std::function<void(float)> function)
+	{
+		addSystem(phase, SystemAccess(), std::move(function));
+	}
+
+	void Scene::addSystem(SystemPhase phase, const SystemAccess& access, std::function<void(float)> function)
+	{
+		System system = {};
+		system.phase = phase;
+		system.access = access;
+		system.function = std::move(function);
+		m_systems.push_back(std::move(system));
+
+		m_scheduleDirty = true;
+	}
+
+	EntityHandle Scene::create()
+	{
+		uint32_t index = 0;
+
+		// Reuse the most recently freed index
+		if (m_emptyIndices.size() > 0)
+		{
+			index = m_emptyIndices.back();
+			m_emptyIndices.pop_back();
+		}
+		else
+		{
+			index = static_cast<uint32_t>(m_generations.size());
+			m_generations.push_back(1);
 		}
 
-		auto t = addComponent<snk::Transform>(m_handleCounter++);
-		return t->getEntity().getHandle();
+		EntityHandle handle = Entity::makeHandle(index, m_generations[index]);
+		addComponent<snk::Transform>(handle);
+		return handle;
 	}
 
-	void Scene::destroy(size_t obj)
+	void Scene::destroy(EntityHandle obj)
 	{
-		m_markedEntitiesForDelete.push_back(obj);
+		if (!isValid(obj))
+			return;
+
+		uint32_t index = Entity::getIndex(obj);
+
+		if (index >= m_markedEntities.size())
+			m_markedEntities.resize(index + 1, false);
+
+		// Ignore entities that are already going away
+		if (m_markedEntities[index])
+			return;
+
+		m_markedEntities[index] = true;
+		m_markedEntitiesForDelete.push_back(index);
 	}
 
 	void Scene::destroyMarkedEntities()
@@ -68,43 +139,267 @@ namespace snk
 		if (m_markedEntitiesForDelete.size() == 0)
 			return;
 
-		// Loop over every component type
-		for (size_t i = 0; i < m_components.size(); i++)
-			// Loop over every component of type i
-			for (size_t j = 0; j < m_components[i].size(); j++)
-				// Loop over every entity marked for deletion
-				for (size_t k = 0; k < m_markedEntitiesForDelete.size(); k++)
-					// If this component belongs the kth marked entity mark it for deletion
-					if (m_components[i][j]->getEntity().getHandle() == m_markedEntitiesForDelete[k])
+		// onEnd() may destroy more entities, which wait for the next tick
+		std::vector<uint32_t> marked = {};
+		marked.swap(m_markedEntitiesForDelete);
+
+		// Mark every component in each marked entities signature for deletion
+		for (auto entity : marked)
+			if (entity < m_signatures.size())
+				for (auto id : m_signatures[entity])
+					m_markedComponentsForDelete.push_back({ entity, id });
+
+		// Destroy the components while handles are still valid for onEnd()
+		destroyMarkedComponents();
+
+		for (auto entity : marked)
+		{
+			m_markedEntities[entity] = false;
+
+			// Invalidate outstanding handles, skipping the null generation on wrap around
+			if (++m_generations[entity] == 0)
+				m_generations[entity] = 1;
+
+			m_emptyIndices.push_back(entity);
+		}
+	}
+
+	void Scene::destroyMarkedComponents()
+	{
+		// Don't bother doing anything if the list is empty
+		if (m_markedComponentsForDelete.size() == 0)
+			return;
+
+		// onEnd() may remove more components, which wait for the next tick
+		std::vector<std::pair<size_t, ComponentID>> marked = {};
+		marked.swap(m_markedComponentsForDelete);
+
+		// Group removals by pool and drop components marked more than once
+		std::sort
+		(
+			marked.begin(), 
+			marked.end(), 
+			[](const std::pair<size_t, ComponentID>& a, const std::pair<size_t, ComponentID>& b)
+			{
+				return a.second != b.second ? a.second < b.second : a.first < b.first;
+			}
+		);
+
+		marked.erase
+		(
+			std::unique(marked.begin(), marked.end()), 
+			marked.end()
+		);
+
+		// Run onEnd() first so components can still reach each other
+		for (const auto& component : marked)
+		{
+			Component* instance = m_pools[component.second]->get(component.first);
+
+			if (instance && instance->getRunOnEnd())
+				instance->onEnd();
+		}
+
+		// Swap and pop every marked component out of its pool
+		for (const auto& component : marked)
+			if (m_pools[component.second]->contains(component.first))
+			{
+				if (component.second < m_archetypeOwners.size() && m_archetypeOwners[component.second])
+					unpackArchetype(m_archetypeOwners[component.second], component.first);
+
+				m_pools[component.second]->remove(component.first);
+				unindexComponent(component.first, component.second);
+			}
+	}
+
+	void Scene::indexComponent(size_t entityIndex, ComponentID id)
+	{
+		if (id >= m_lookup.size())
+			m_lookup.resize(id + 1);
+
+		if (entityIndex >= m_lookup[id].size())
+			m_lookup[id].resize(entityIndex + 1, IComponentPool::npos);
+
+		if (entityIndex >= m_signatures.size())
+			m_signatures.resize(entityIndex + 1);
+
+		m_signatures[entityIndex].push_back(id);
+
+		// The exact type always wins
+		m_lookup[id][entityIndex] = id;
+
+		// Ancestors only point at us if they aren't satisfied already
+		for (auto ancestor : Component::getAncestorIDs(id))
+		{
+			if (ancestor >= m_lookup.size())
+				m_lookup.resize(ancestor + 1);
+
+			if (entityIndex >= m_lookup[ancestor].size())
+				m_lookup[ancestor].resize(entityIndex + 1, IComponentPool::npos);
+
+			if (m_lookup[ancestor][entityIndex] == IComponentPool::npos)
+				m_lookup[ancestor][entityIndex] = id;
+		}
+	}
+
+	void Scene::unindexComponent(size_t entityIndex, ComponentID id)
+	{
+		// Swap and pop the component out of the entities signature
+		auto& signature = m_signatures[entityIndex];
+		auto it = std::find(signature.begin(), signature.end(), id);
+		*it = signature.back();
+		signature.pop_back();
+
+		// Every type that could have resolved to the removed component
+		std::vector<ComponentID> types = Component::getAncestorIDs(id);
+		types.push_back(id);
+
+		for (auto type : types)
+		{
+			if (findComponentID(type, entityIndex) != id)
+				continue;
+
+			ComponentID replacement = IComponentPool::npos;
+
+			// Fall back to the type itself, then to another descendant
+			if (type < m_pools.size() && m_pools[type] && m_pools[type]->contains(entityIndex))
+				replacement = type;
+			else
+				for (auto descendant : Component::getDescendantIDs(type))
+					if (descendant < m_pools.size() && m_pools[descendant] && m_pools[descendant]->contains(entityIndex))
 					{
-						m_markedComponentsForDelete.push_back(m_components[i][j].get());
+						replacement = descendant;
 						break;
 					}
 
-		// Add every marked entity to the empty handle list
-		for (size_t i = 0; i < m_markedEntitiesForDelete.size(); i++)
-			m_emptyHandles.push_back(m_markedEntitiesForDelete[i]);
+			m_lookup[type][entityIndex] = replacement;
+		}
+	}
+
+	void Scene::registerPhases(ComponentID id)
+	{
+		auto insert = [id](std::vector<ComponentID>& pools)
+		{
+			pools.insert(std::upper_bound(pools.begin(), pools.end(), id), id);
+		};
+
+		if (m_pools[id]->runsTick())
+			insert(m_tickPools);
 
-		// Empty marked list
-		m_markedEntitiesForDelete.clear();
+		if (m_pools[id]->runsLateTick())
+			insert(m_lateTickPools);
+
+		if (m_pools[id]->runsPreRender())
+			insert(m_preRenderPools);
 	}
 
-	void Scene::destroyMarkedComponents()
+	void Scene::buildSchedule()
 	{
-		// Loop over every marked component
-		for (auto component : m_markedComponentsForDelete)
-			// Loop over every component of "component"s type
-			for (size_t j = 0; j < m_components[component->getID()].size(); j++)
-				// If the component is the same then destroy it and break
-				if (m_components[component->getID()][j].get() == component)
-				{
-					if (m_components[component->getID()][j]->getRunOnEnd())
-						m_components[component->getID()][j]->onEnd();
-
-					m_components[component->getID()].erase(m_components[component->getID()].begin() + j);
-					break;
-				}
-
-		m_markedComponentsForDelete.clear();
+		m_schedule.clear();
+		m_schedule.resize(3);
+
+		// Batch each system runs in
+		std::vector<size_t> batches(m_systems.size(), 0);
+
+		for (size_t i = 0; i < m_systems.size(); i++)
+		{
+			// Run after every earlier conflicting system in the same phase
+			size_t batch = 0;
+			for (size_t j = 0; j < i; j++)
+				if (m_systems[j].phase == m_systems[i].phase && m_systems[j].access.conflictsWith(m_systems[i].access))
+					batch = std::max(batch, batches[j] + 1);
+
+			batches[i] = batch;
+
+			auto& schedule = m_schedule[static_cast<size_t>(m_systems[i].phase)];
+			if (batch >= schedule.size())
+				schedule.resize(batch + 1);
+
+			schedule[batch].push_back(i);
+		}
+
+		m_scheduleDirty = false;
+	}
+
+	void Scene::runSystems(SystemPhase phase, float deltaTime)
+	{
+		if (m_scheduleDirty)
+			buildSchedule();
+
+		for (const auto& batch : m_schedule[static_cast<size_t>(phase)])
+		{
+			// Run alone on this thread
+			if (batch.size() == 1 || m_threadPool == nullptr)
+			{
+				for (auto index : batch)
+					m_systems[index].function(deltaTime);
+
+				continue;
+			}
+
+			// Hand every system but the last to the pool and run the last one here
+			JobCounter counter;
+			for (size_t i = 0; i < batch.size() - 1; i++)
+			{
+				System* system = &m_systems[batch[i]];
+				m_threadPool->addJob([system, deltaTime]() { system->function(deltaTime); }, &counter);
+			}
+
+			m_systems[batch[batch.size() - 1]].function(deltaTime);
+			m_threadPool->wait(counter);
+		}
+	}
+
+	void Scene::packArchetype(Archetype* archetype, size_t entityIndex)
+	{
+		// Only entities with every type belong to the archetype
+		for (auto pool : archetype->pools)
+			if (!pool->contains(entityIndex))
+				return;
+
+		// Already packed
+		if (archetype->pools[0]->indexOf(entityIndex) < archetype->size)
+			return;
+
+		for (auto pool : archetype->pools)
+			pool->swap(pool->indexOf(entityIndex), archetype->size);
+
+		archetype->size++;
+	}
+
+	void Scene::unpackArchetype(Archetype* archetype, size_t entityIndex)
+	{
+		// Find a pool that still holds the entity
+		IComponentPool* holder = nullptr;
+		for (auto pool : archetype->pools)
+			if (pool->contains(entityIndex))
+			{
+				holder = pool;
+				break;
+			}
+
+		// Not packed
+		if (holder == nullptr || holder->indexOf(entityIndex) >= archetype->size)
+			return;
+
+		archetype->size--;
+
+		for (auto pool : archetype->pools)
+			if (pool->contains(entityIndex))
+				pool->swap(pool->indexOf(entityIndex), archetype->size);
+	}
+
+	const Archetype* Scene::findArchetype(std::vector<ComponentID> ids) const
+	{
+		if (ids.size() == 0 || ids[0] >= m_archetypeOwners.size() || m_archetypeOwners[ids[0]] == nullptr)
+			return nullptr;
+
+		const Archetype* archetype = m_archetypeOwners[ids[0]];
+		std::vector<ComponentID> archetypeIDs = archetype->ids;
+
+		std::sort(ids.begin(), ids.end());
+		std::sort(archetypeIDs.begin(), archetypeIDs.end());
+
+		return ids == archetypeIDs ? archetype : nullptr;
 	}
 }
\ No newline at end of file
@@ -9,12 +9,19 @@
 /** Includes. */
 #include <memory>
 #include <vector>
+#include <cassert>
+#include <glm\glm.hpp>
+#include "Component.hpp"
+#include "ComponentPool.hpp"
+#include "Query.hpp"
+#include "System.hpp"
+#include "TransformHierarchy.hpp"
 
 namespace snk
 {
 	class Transform;
 
-	class Component;
+	class ThreadPool;
 
 	/**
 	 * @class Scene
@@ -46,14 +53,26 @@ namespace snk
 		 * @brief Create a new entity.
 		 * @return New entiy's handle.
 		 */
-		size_t create();
+		EntityHandle create();
 
 		/**
 		 * @brief Destroy the given entity.
 		 * @param Entity handle.
 		 * @note Destroys the entity on the next tick.
 		 */
-		void destroy(size_t entity);
+		void destroy(EntityHandle entity);
+
+		/**
+		 * @brief Get if a handle refers to an existing entity.
+		 * @param Entity handle.
+		 * @return If the entity exists.
+		 * @note Entities marked for destruction stay valid until the next tick.
+		 */
+		inline bool isValid(EntityHandle entityHandle) const
+		{
+			uint32_t index = Entity::getIndex(entityHandle);
+			return index < m_generations.size() && m_generations[index] == Entity::getGeneration(entityHandle);
+		}
 
 		/**
 		 * @brief Get if a entity has a component.
@@ -61,7 +80,7 @@ namespace snk
 		 * @return If the entity has the component.
 		 */
 		template<class T>
-		bool hasComponent(size_t entityHandle)
+		bool hasComponent(EntityHandle entityHandle)
 		{
 			return getComponent<T>(entityHandle) != nullptr;
 		}
@@ -73,24 +92,21 @@ namespace snk
 		 * @note Returns nullptr if the entity doesn't contain the component.
 		 */
 		template<class T>
-		T* getComponent(size_t entityHandle)
+		T* getComponent(EntityHandle entityHandle)
 		{
-			// Get the unique ID of the given component
-			ComponentID uniqueID = Component::getUniqueID<T>();
+			// Stale handles have no components
+			if (!isValid(entityHandle))
+				return nullptr;
+
+			uint32_t index = Entity::getIndex(entityHandle);
 
-			// Find the component belonging to the given entity handle
-			for (auto& component : m_components[uniqueID])
-				if (component->getEntity().getHandle() == entityHandle)
-					return static_cast<T*>(component.get());
+			// Find the type of the component satisfying T
+			ComponentID concreteID = findComponentID(Component::getUniqueID<T>(), index);
 
-			// Check for inherited components
-			auto inheritedComps = Component::getPolymorphicIDs<T>();
-			for (auto inheritedComp : inheritedComps)
-				for (auto& component : m_components[inheritedComp])
-					if (component->getEntity().getHandle() == entityHandle)
-						return static_cast<T*>(component.get());
+			if (concreteID == IComponentPool::npos)
+				return nullptr;
 
-			return nullptr;
+			return static_cast<T*>(m_pools[concreteID]->get(index));
 		}
 
 		/**
@@ -98,10 +114,18 @@ namespace snk
 		 * @param Entity of game object to add component to.
 		 * @return Pointer to new component.
 		 * @note If the entity already contains a component of the same type it will return that instead.
+		 *		 If the type belongs to a registered archetype, components of that archetype may move,
+		 *		 invalidating pointers to them.
+		 * @see registerArchetype
 		 */
 		template<class T>
-		T* addComponent(size_t entityHandle)
+		T* addComponent(EntityHandle entityHandle)
 		{
+			// Can't add components to destroyed entities
+			assert(isValid(entityHandle));
+			if (!isValid(entityHandle))
+				return nullptr;
+
 			// Get the unique ID of the given component
 			ComponentID uniqueID = Component::getUniqueID<T>();
 
@@ -114,13 +138,22 @@ namespace snk
 			}
 
 			// Create component
-			m_components[uniqueID].push_back(std::make_unique<T>(this, Entity(this, entityHandle), uniqueID));
-			auto newComponent = m_components[uniqueID][m_components[uniqueID].size() - 1].get();
+			uint32_t index = Entity::getIndex(entityHandle);
+			ComponentPool<T>* pool = getPool<T>();
+			T* newComponent = pool->add(index, this, Entity(this, entityHandle), uniqueID);
+			indexComponent(index, uniqueID);
+
+			// Packing into an archetype can move the new component
+			if (uniqueID < m_archetypeOwners.size() && m_archetypeOwners[uniqueID])
+			{
+				packArchetype(m_archetypeOwners[uniqueID], index);
+				newComponent = pool->slot(pool->indexOf(index));
+			}
 
 			if (newComponent->getRunOnBegin())
 				newComponent->onBegin();
 
-			return static_cast<T*>(newComponent);
+			return newComponent;
 		}
 
 		/**
@@ -128,18 +161,161 @@ namespace snk
 		 * @param Entity to remove component from.
 		 */
 		template<class T>
-		void removeComponent(size_t entityHandle)
+		void removeComponent(EntityHandle entityHandle)
 		{
-			ComponentID uniqueID = Component::getUniqueID<T>();
+			T* component = getComponent<T>(entityHandle);
 
-			if (!hasComponent<T>(entityHandle) && uniqueID != Component::getUniqueID<Transform>())
+			if (component == nullptr)
 				return;
 
-			m_markedComponentsForDelete.push_back(getComponent<T>(entityHandle));
+			m_markedComponentsForDelete.push_back({ Entity::getIndex(entityHandle), component->getID() });
+		}
+
+		/**
+		 * @brief Set the thread pool systems run on.
+		 * @param Thread pool, or nullptr to run every system on the calling thread.
+		 */
+		inline void setThreadPool(ThreadPool* threadPool)
+		{
+			m_threadPool = threadPool;
+		}
+
+		/**
+		 * @brief Get the scenes transform hierarchy.
+		 * @return Transform hierarchy.
+		 */
+		inline TransformHierarchy& getTransformHierarchy()
+		{
+			return m_transformHierarchy;
+		}
+
+		/**
+		 * @brief Resolve the world values of every changed transform in one pass over the hierarchy.
+		 * @note Each depth of the hierarchy is split over the thread pool.
+		 *		 Registered as a pre-render system by the engine, so parallel readers find them resolved.
+		 */
+		inline void resolveTransforms()
+		{
+			m_transformHierarchy.resolve(m_threadPool);
+		}
+
+		/**
+		 * @brief Set the local positions of many entities at once.
+		 * @param Entities. Each may only appear once.
+		 * @param Local positions, one per entity.
+		 * @param Number of entities.
+		 * @note Entities are split over the thread pool. Each one only writes and flags its own
+		 *		 hierarchy row and descendants inherit the flag while resolving, so a parent and its
+		 *		 children may be set in the same call. World values are resolved at the next PreRender
+		 *		 resolve, the resolveTransforms() system the engine runs once per frame, or on first read.
+		 *		 Entities without a transform are skipped.
+		 */
+		void setLocalPositions(const EntityHandle* entities, const glm::vec3* positions, size_t count);
+
+		/**
+		 * @brief Set the local rotations of many entities at once.
+		 * @param Entities. Each may only appear once.
+		 * @param Local rotations, one per entity.
+		 * @param Number of entities.
+		 * @see setLocalPositions
+		 */
+		void setLocalRotations(const EntityHandle* entities, const float* rotations, size_t count);
+
+		/**
+		 * @brief Set the local scales of many entities at once.
+		 * @param Entities. Each may only appear once.
+		 * @param Local scales, one per entity.
+		 * @param Number of entities.
+		 * @see setLocalPositions
+		 */
+		void setLocalScales(const EntityHandle* entities, const glm::vec2* scales, size_t count);
+
+		/**
+		 * @brief Add an exclusive system to the scene.
+		 * @param Phase to run the system in.
+		 * @param Function to run. Receives the delta time.
+		 * @note Systems run after the component callbacks of their phase.
+		 */
+		void addSystem(SystemPhase phase, std::function<void(float)> function);
+
+		/**
+		 * @brief Add a system to the scene.
+		 * @param Phase to run the system in.
+		 * @param Component types the system reads and writes.
+		 * @param Function to run. Receives the delta time.
+		 * @note Systems that don't conflict run in parallel. Conflicting systems run in the order they were added.
+		 */
+		void addSystem(SystemPhase phase, const SystemAccess& access, std::function<void(float)> function);
+
+		/**
+		 * @brief Store the given component types as an archetype.
+		 * @return If the archetype was registered.
+		 * @note Entities with every type are kept packed at the front of each types pool,
+		 *		 so querying exactly these types iterates them in lockstep. A type can only
+		 *		 belong to one archetype, and packing moves components, so pointers to them
+		 *		 are only stable until the next component of these types is added or removed.
+		 *		 Once registered, a held pointer can silently refer to another entity's component,
+		 *		 so keep entity handles instead. Nothing is registered unless the game opts in.
+		 */
+		template<class... ComponentTypes>
+		bool registerArchetype()
+		{
+			std::vector<ComponentID> ids = Component::getUniqueIDs<ComponentTypes...>();
+
+			// Make sure every pool exists and none is owned already
+			std::vector<IComponentPool*> pools = { getPool<ComponentTypes>()... };
+
+			for (auto id : ids)
+				if (id < m_archetypeOwners.size() && m_archetypeOwners[id])
+					return false;
+
+			m_archetypes.push_back(std::make_unique<Archetype>());
+			Archetype* archetype = m_archetypes[m_archetypes.size() - 1].get();
+			archetype->ids = ids;
+			archetype->pools = pools;
+
+			for (auto id : ids)
+			{
+				if (id >= m_archetypeOwners.size())
+					m_archetypeOwners.resize(id + 1, nullptr);
+
+				m_archetypeOwners[id] = archetype;
+			}
+
+			// Pack entities that already have every type
+			for (size_t i = 0; i < pools[0]->size(); i++)
+				packArchetype(archetype, pools[0]->getEntity(i));
+
+			return true;
+		}
+
+		/**
+		 * @brief Query every entity with all of the given component types.
+		 * @return Query to iterate.
+		 * @note Iterates in lockstep without lookups if the types were registered as an archetype.
+		 */
+		template<class... ComponentTypes>
+		Query<ComponentTypes...> query()
+		{
+			return Query<ComponentTypes...>
+			(
+				std::make_tuple(findPool<ComponentTypes>()...), 
+				findArchetype(Component::getUniqueIDs<ComponentTypes...>())
+			);
 		}
 
 	private:
 
+		/**
+		 * @brief Run a function on the transform of every entity in a list, in parallel.
+		 * @param Entities.
+		 * @param Number of entities.
+		 * @param Function taking a transform and the index of its entity in the list.
+		 * @note The function may only write the row of the transform it is given.
+		 */
+		template<class Function>
+		void forEachTransform(const EntityHandle* entities, size_t count, Function function);
+
 		/**
 		 * @brief Destroy entities marked for delete.
 		 */
@@ -150,21 +326,208 @@ namespace snk
 		 */
 		void destroyMarkedComponents();
 
+		/**
+		 * @brief Find the type of an entities component that satisfies a component type.
+		 * @param Component ID to look for.
+		 * @param Entity index.
+		 * @return ID of the type itself or a registered descendant, npos if there is none.
+		 */
+		inline ComponentID findComponentID(ComponentID id, size_t entityIndex) const
+		{
+			if (id >= m_lookup.size() || entityIndex >= m_lookup[id].size())
+				return IComponentPool::npos;
+
+			return m_lookup[id][entityIndex];
+		}
+
+		/**
+		 * @brief Add a new component to the entities signature and to the lookup of its type and every ancestor type.
+		 * @param Entity index.
+		 * @param Component ID.
+		 */
+		void indexComponent(size_t entityIndex, ComponentID id);
+
+		/**
+		 * @brief Remove a destroyed component from the entities signature and from the lookup of its type and every ancestor type.
+		 * @param Entity index.
+		 * @param Component ID.
+		 */
+		void unindexComponent(size_t entityIndex, ComponentID id);
+
+		/**
+		 * @brief Add a new pool to the phases its component type overrides.
+		 * @param Component ID of the pool.
+		 */
+		void registerPhases(ComponentID id);
+
+		/**
+		 * @brief Group the systems of every phase into batches that can run in parallel.
+		 */
+		void buildSchedule();
+
+		/**
+		 * @brief Run every system in a phase.
+		 * @param Phase.
+		 * @param Delta time.
+		 */
+		void runSystems(SystemPhase phase, float deltaTime);
+
+		/**
+		 * @brief Move an entity into the packed part of an archetype if it has every type.
+		 * @param Archetype.
+		 * @param Entity index.
+		 */
+		void packArchetype(Archetype* archetype, size_t entityIndex);
+
+		/**
+		 * @brief Move an entity out of the packed part of an archetype.
+		 * @param Archetype.
+		 * @param Entity index.
+		 */
+		void unpackArchetype(Archetype* archetype, size_t entityIndex);
+
+		/**
+		 * @brief Find the archetype made of exactly the given component types.
+		 * @param Component IDs.
+		 * @return Archetype or nullptr if there is none.
+		 */
+		const Archetype* findArchetype(std::vector<ComponentID> ids) const;
+
+		/**
+		 * @brief Get the pool storing components of type T if it exists.
+		 * @return Component pool or nullptr.
+		 */
+		template<class T>
+		ComponentPool<T>* findPool()
+		{
+			ComponentID uniqueID = Component::getUniqueID<T>();
+
+			if (uniqueID >= m_pools.size())
+				return nullptr;
+
+			return static_cast<ComponentPool<T>*>(m_pools[uniqueID].get());
+		}
+
+		/**
+		 * @brief Get the pool storing components of type T.
+		 * @return Component pool.
+		 * @note Creates the pool if it doesn't exist yet.
+		 */
+		template<class T>
+		ComponentPool<T>* getPool()
+		{
+			ComponentID uniqueID = Component::getUniqueID<T>();
+
+			if (uniqueID >= m_pools.size())
+				m_pools.resize(uniqueID + 1);
+
+			if (!m_pools[uniqueID])
+			{
+				m_pools[uniqueID] = std::make_unique<ComponentPool<T>>();
+				registerPhases(uniqueID);
+			}
+
+			return static_cast<ComponentPool<T>*>(m_pools[uniqueID].get());
+		}
+
+
+
+		/** Component pools ordered by their IDs. */
+		std::vector<std::unique_ptr<IComponentPool>> m_pools = {};
+
+		/** Entity index to the IDs of every component attached to it. */
+		std::vector<std::vector<ComponentID>> m_signatures = {};
+
+		/** Entity index to whether it is already marked for deletion. */
+		std::vector<bool> m_markedEntities = {};
+
+		/** Per component type, entity index to the ID of the component satisfying the type. */
+		std::vector<std::vector<ComponentID>> m_lookup = {};
+
+		/** IDs of pools that run onTick(), in ID order. */
+		std::vector<ComponentID> m_tickPools = {};
+
+		/** IDs of pools that run onLateTick(), in ID order. */
+		std::vector<ComponentID> m_lateTickPools = {};
+
+		/** IDs of pools that run onPreRender(), in ID order. */
+		std::vector<ComponentID> m_preRenderPools = {};
 
+		/** Systems in the order they were added. */
+		std::vector<System> m_systems = {};
 
-		/** Component lists ordered by their IDs. */
-		std::vector<std::vector<std::unique_ptr<Component>>> m_components;
+		/** Per phase, batches of systems to run one after another. */
+		std::vector<std::vector<SystemBatch>> m_schedule = {};
 
-		/** Components to be deleted. */
-		std::vector<Component*> m_markedComponentsForDelete = {};
+		/** Does the schedule need to be rebuilt? */
+		bool m_scheduleDirty = true;
 
-		/** Entities to be deleted. */
-		std::vector<size_t> m_markedEntitiesForDelete = {};
+		/** Thread pool to run systems on. */
+		ThreadPool* m_threadPool = nullptr;
 
-		/** Entity handles that can be reused. */
-		std::vector<size_t> m_emptyHandles = {};
+		/** Values of every transform. Outlives the pools, which are cleared by the destructor. */
+		TransformHierarchy m_transformHierarchy = {};
 
-		/** Entity handle counter. */
-		size_t m_handleCounter = 0;
+		/** Registered archetypes. */
+		std::vector<std::unique_ptr<Archetype>> m_archetypes = {};
+
+		/** Component ID to the archetype owning its pool. */
+		std::vector<Archetype*> m_archetypeOwners = {};
+
+		/** Components to be deleted as (entity index, component ID) pairs. */
+		std::vector<std::pair<size_t, ComponentID>> m_markedComponentsForDelete = {};
+
+		/** Indices of entities to be deleted. */
+		std::vector<uint32_t> m_markedEntitiesForDelete = {};
+
+		/** Entity indices that can be reused, most recently freed last. */
+		std::vector<uint32_t> m_emptyIndices = {};
+
+		/** Current generation of every entity index. */
+		std::vector<uint32_t> m_generations = {};
 	};
+
+
+
+	template<class T>
+	bool Entity::hasComponent()
+	{
+		return m_scene->hasComponent<T>(m_handle);
+	}
+
+	template<class T>
+	T* Entity::getComponent()
+	{
+		return m_scene->getComponent<T>(m_handle);
+	}
+
+	template<class T>
+	T* Entity::addComponent()
+	{
+		return m_scene->addComponent<T>(m_handle);
+	}
+
+	template<class T>
+	void Entity::removeComponent()
+	{
+		m_scene->removeComponent<T>(m_handle);
+	}
+
+	template<class... ComponentTypes>
+	SystemAccess& SystemAccess::read()
+	{
+		std::vector<ComponentID> ids = Component::getUniqueIDs<ComponentTypes...>();
+		reads.insert(reads.end(), ids.begin(), ids.end());
+		exclusive = false;
+		return *this;
+	}
+
+	template<class... ComponentTypes>
+	SystemAccess& SystemAccess::write()
+	{
+		std::vector<ComponentID> ids = Component::getUniqueIDs<ComponentTypes...>();
+		writes.insert(writes.end(), ids.begin(), ids.end());
+		exclusive = false;
+		return *this;
+	}
 }
\ No newline at end of file
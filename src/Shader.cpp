@@ -1,9 +1,375 @@
+#include <cstdio>
+#include <cctype>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
 #include <iostream>
+#include <SDL.h>
 #include "Shader.hpp"
+#include "Utilities.hpp"
 
 namespace snk
 {
-	Shader::Shader(const std::string& vertexSource, const std::string& fragmentSource)
+	std::string Shader::cacheDirectory = "";
+
+	/** Program binary entry points. Core in 4.1, so glad doesn't load them for 3.3. */
+	typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+	typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+	typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+	/** Program binary enums. */
+	static constexpr GLenum programBinaryRetrievableHint = 0x8257;
+	static constexpr GLenum programBinaryLength = 0x8741;
+
+	/** Magic number at the start of every cached binary. */
+	static constexpr uint32_t binaryMagic = 0x534E4B42;
+
+	/**
+	 * @struct BinaryHeader
+	 * @brief Header of a cached program binary.
+	 */
+	struct BinaryHeader
+	{
+		/** Magic number. */
+		uint32_t magic = binaryMagic;
+
+		/** Driver specific binary format. */
+		uint32_t format = 0;
+
+		/** Cache key. */
+		uint64_t key = 0;
+	};
+
+	/**
+	 * @struct BinaryFunctions
+	 * @brief Program binary entry points, if the driver has them.
+	 */
+	struct BinaryFunctions
+	{
+		/** glGetProgramBinary */
+		GetProgramBinaryProc getProgramBinary = nullptr;
+
+		/** glProgramBinary */
+		ProgramBinaryProc programBinary = nullptr;
+
+		/** glProgramParameteri */
+		ProgramParameteriProc programParameteri = nullptr;
+	};
+
+	/**
+	 * @brief Load the program binary entry points once.
+	 * @return Entry points.
+	 * @note Needs a current context the first time.
+	 */
+	static const BinaryFunctions& getBinaryFunctions()
+	{
+		static BinaryFunctions functions = []()
+		{
+			BinaryFunctions loaded = {};
+			loaded.getProgramBinary = reinterpret_cast<GetProgramBinaryProc>(SDL_GL_GetProcAddress("glGetProgramBinary"));
+			loaded.programBinary = reinterpret_cast<ProgramBinaryProc>(SDL_GL_GetProcAddress("glProgramBinary"));
+			loaded.programParameteri = reinterpret_cast<ProgramParameteriProc>(SDL_GL_GetProcAddress("glProgramParameteri"));
+			return loaded;
+		}();
+
+		return functions;
+	}
+
+	/**
+	 * @brief Get the path of a cached binary.
+	 * @param Cache directory.
+	 * @param Cache key.
+	 * @return Path.
+	 */
+	static std::string getBinaryPath(const std::string& directory, uint64_t key)
+	{
+		char name[32] = {};
+		std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+		return directory + name;
+	}
+
+	/**
+	 * @brief Get if a preprocessor conditional in a source tests a define.
+	 * @param Source.
+	 * @param Define name.
+	 * @return If an #if, #ifdef, #ifndef, or #elif line names the define.
+	 */
+	static bool testsDefine(const std::string& source, const std::string& name)
+	{
+		size_t lineStart = 0;
+		while (lineStart < source.size())
+		{
+			size_t lineEnd = source.find('\n', lineStart);
+			if (lineEnd == std::string::npos)
+				lineEnd = source.size();
+
+			// Directive lines start with # after optional whitespace
+			size_t i = source.find_first_not_of(" \t", lineStart);
+			if (i < lineEnd && source[i] == '#')
+			{
+				i = std::min(source.find_first_not_of(" \t", i + 1), lineEnd);
+				size_t directiveEnd = std::min(source.find_first_of(" \t(", i), lineEnd);
+				std::string directive = source.substr(i, directiveEnd - i);
+
+				if (directive == "if" || directive == "ifdef" || directive == "ifndef" || directive == "elif")
+				{
+					// Compare every identifier up to a comment
+					size_t end = std::min(source.find("//", directiveEnd), lineEnd);
+					for (size_t j = directiveEnd; j < end;)
+					{
+						if (!std::isalpha(static_cast<unsigned char>(source[j])) && source[j] != '_')
+						{
+							j++;
+							continue;
+						}
+
+						size_t identifierEnd = j;
+						while (identifierEnd < end && (std::isalnum(static_cast<unsigned char>(source[identifierEnd])) || source[identifierEnd] == '_'))
+							identifierEnd++;
+
+						if (source.compare(j, identifierEnd - j, name) == 0 && identifierEnd - j == name.size())
+							return true;
+
+						j = identifierEnd;
+					}
+				}
+			}
+
+			lineStart = lineEnd + 1;
+		}
+
+		return false;
+	}
+
+
+
+	Shader::Shader(const std::string& vertexSource, const std::string& fragmentSource) : m_vertexSource(vertexSource), m_fragmentSource(fragmentSource)
+	{
+		// Features the sources test for can be turned on
+		const std::pair<ShaderFeature, const char*> features[] =
+		{
+			{ ShaderFeature::Instanced, "INSTANCED" },
+			{ ShaderFeature::Batched, "BATCHED" },
+			{ ShaderFeature::Textured, "TEXTURED" },
+			{ ShaderFeature::AlphaTest, "ALPHA_TEST" }
+		};
+
+		for (const auto& feature : features)
+			if (testsDefine(vertexSource, feature.second) || testsDefine(fragmentSource, feature.second))
+				m_supportedFeatures = m_supportedFeatures | feature.first;
+
+		build(vertexSource, fragmentSource);
+	}
+
+	Shader::Shader(Shader* root, ShaderFeature features) : m_features(features), m_supportedFeatures(root->m_supportedFeatures), m_root(root)
+	{
+		build(injectDefines(root->m_vertexSource, features), injectDefines(root->m_fragmentSource, features));
+	}
+
+	Shader* Shader::getVariant(ShaderFeature features)
+	{
+		if (m_root)
+			return m_root->getVariant(features);
+
+		features = features & m_supportedFeatures;
+		if (features == ShaderFeature::None)
+			return this;
+
+		auto& variant = m_variants[static_cast<uint32_t>(features)];
+		if (!variant)
+			variant = std::unique_ptr<Shader>(new Shader(this, features));
+
+		return variant.get();
+	}
+
+	std::string Shader::injectDefines(const std::string& source, ShaderFeature features)
+	{
+		std::string defines = "";
+		if (hasFeature(features, ShaderFeature::Instanced))
+			defines += "#define INSTANCED\n";
+
+		if (hasFeature(features, ShaderFeature::Batched))
+			defines += "#define BATCHED\n";
+
+		if (hasFeature(features, ShaderFeature::Textured))
+			defines += "#define TEXTURED\n";
+
+		if (hasFeature(features, ShaderFeature::AlphaTest))
+			defines += "#define ALPHA_TEST\n";
+
+		// #version has to stay first
+		size_t insert = 0;
+		if (source.compare(0, 8, "#version") == 0)
+		{
+			insert = source.find('\n');
+			insert = insert == std::string::npos ? source.size() : insert + 1;
+		}
+
+		return source.substr(0, insert) + defines + source.substr(insert);
+	}
+
+	void Shader::build(const std::string& vertexSource, const std::string& fragmentSource)
+	{
+		m_program = glCreateProgram();
+
+		// Key the cache by the sources and the driver
+		uint64_t key = 0;
+		if (!cacheDirectory.empty())
+		{
+			key = hashBytes(vertexSource.data(), vertexSource.size() + 1);
+			key = hashBytes(fragmentSource.data(), fragmentSource.size() + 1, key);
+
+			const GLenum strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+			for (auto string : strings)
+			{
+				const char* value = reinterpret_cast<const char*>(glGetString(string));
+				if (value)
+					key = hashBytes(value, std::strlen(value) + 1, key);
+			}
+		}
+
+		// Compile from source if there's no usable binary
+		if (cacheDirectory.empty() || !loadBinary(key))
+			if (compile(vertexSource, fragmentSource) && !cacheDirectory.empty())
+				saveBinary(key);
+
+		reflect();
+
+		// Camera data comes from the renderers uniform buffer
+		if (const ShaderBlock* camera = findBlock("Camera"))
+			glUniformBlockBinding(m_program, camera->index, cameraBinding);
+
+		// Uniforms the renderer sets every draw
+		if (const ShaderUniform* basis = findUniform("modelBasis"))
+			m_modelBasisLocation = basis->location;
+
+		if (const ShaderUniform* translation = findUniform("modelTranslation"))
+			m_modelTranslationLocation = translation->location;
+
+		if (const ShaderUniform* tint = findUniform("tint"))
+			m_tintLocation = tint->location;
+	}
+
+	Shader::~Shader()
+	{
+		// Cleanup
+		glUseProgram(0);
+		glDeleteProgram(m_program);
+	}
+
+	void Shader::getPrograms(std::vector<GLuint>& programs) const
+	{
+		programs.push_back(m_program);
+
+		for (const auto& variant : m_variants)
+			variant.second->getPrograms(programs);
+	}
+
+	const ShaderUniform* Shader::findUniform(const std::string& name) const
+	{
+		auto iterator = m_uniformIndices.find(name);
+		return iterator == m_uniformIndices.end() ? nullptr : &m_uniforms[iterator->second];
+	}
+
+	const ShaderAttribute* Shader::findAttribute(const std::string& name) const
+	{
+		auto iterator = m_attributeIndices.find(name);
+		return iterator == m_attributeIndices.end() ? nullptr : &m_attributes[iterator->second];
+	}
+
+	const ShaderBlock* Shader::findBlock(const std::string& name) const
+	{
+		auto iterator = m_blockIndices.find(name);
+		return iterator == m_blockIndices.end() ? nullptr : &m_blocks[iterator->second];
+	}
+
+	void Shader::reflect()
+	{
+		std::vector<GLchar> name;
+		GLint count = 0;
+		GLint maxLength = 0;
+
+		// Uniforms
+		glGetProgramiv(m_program, GL_ACTIVE_UNIFORMS, &count);
+		glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+		name.resize(static_cast<size_t>(maxLength) + 1);
+
+		for (GLint i = 0; i < count; i++)
+		{
+			ShaderUniform uniform = {};
+			GLsizei length = 0;
+			glGetActiveUniform(m_program, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &length, &uniform.size, &uniform.type, name.data());
+
+			uniform.name = std::string(name.data(), length);
+			uniform.location = glGetUniformLocation(m_program, uniform.name.c_str());
+
+			// Members of uniform blocks have no location
+			if (uniform.location == -1)
+				continue;
+
+			// Arrays are reported as their first element
+			if (uniform.name.size() > 3 && uniform.name.compare(uniform.name.size() - 3, 3, "[0]") == 0)
+				uniform.name.resize(uniform.name.size() - 3);
+
+			switch (uniform.type)
+			{
+			case GL_SAMPLER_1D:
+			case GL_SAMPLER_2D:
+			case GL_SAMPLER_3D:
+			case GL_SAMPLER_CUBE:
+			case GL_SAMPLER_2D_ARRAY:
+			case GL_SAMPLER_2D_SHADOW:
+				uniform.sampler = true;
+				break;
+
+			default:
+				break;
+			}
+
+			m_uniformIndices[uniform.name] = m_uniforms.size();
+			m_uniforms.push_back(uniform);
+		}
+
+		// Attributes
+		glGetProgramiv(m_program, GL_ACTIVE_ATTRIBUTES, &count);
+		glGetProgramiv(m_program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+		name.resize(static_cast<size_t>(maxLength) + 1);
+
+		for (GLint i = 0; i < count; i++)
+		{
+			ShaderAttribute attribute = {};
+			GLsizei length = 0;
+			glGetActiveAttrib(m_program, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &length, &attribute.size, &attribute.type, name.data());
+
+			attribute.name = std::string(name.data(), length);
+			attribute.location = glGetAttribLocation(m_program, attribute.name.c_str());
+
+			m_attributeIndices[attribute.name] = m_attributes.size();
+			m_attributes.push_back(attribute);
+		}
+
+		// Uniform blocks
+		glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+		glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+		name.resize(static_cast<size_t>(maxLength) + 1);
+
+		for (GLint i = 0; i < count; i++)
+		{
+			ShaderBlock block = {};
+			GLsizei length = 0;
+			glGetActiveUniformBlockName(m_program, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &length, name.data());
+
+			block.name = std::string(name.data(), length);
+			block.index = static_cast<GLuint>(i);
+			glGetActiveUniformBlockiv(m_program, block.index, GL_UNIFORM_BLOCK_DATA_SIZE, &block.dataSize);
+
+			m_blockIndices[block.name] = m_blocks.size();
+			m_blocks.push_back(block);
+		}
+	}
+
+	bool Shader::compile(const std::string& vertexSource, const std::string& fragmentSource)
 	{
 		// Create vertex shader
 		GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
@@ -26,23 +392,81 @@ namespace snk
 		std::cout << "Vertex Shader: " << (success == GL_TRUE ? "Pass" : "Fail") << "\n";
 #endif
 
-		// Create shader program
-		m_program = glCreateProgram();
+		// Attach shaders to the program
 		glAttachShader(m_program, vertexShader);
 		glAttachShader(m_program, fragmentShader);
 
+		// Ask the driver to keep the binary around for the cache
+		if (!cacheDirectory.empty() && getBinaryFunctions().programParameteri)
+			getBinaryFunctions().programParameteri(m_program, programBinaryRetrievableHint, GL_TRUE);
+
 		// Link shaders with the program
 		glLinkProgram(m_program);
 
 		// Delete shaders
+		glDetachShader(m_program, vertexShader);
+		glDetachShader(m_program, fragmentShader);
 		glDeleteShader(vertexShader);
 		glDeleteShader(fragmentShader);
+
+		GLint linked = GL_FALSE;
+		glGetProgramiv(m_program, GL_LINK_STATUS, &linked);
+		return linked == GL_TRUE;
 	}
 
-	Shader::~Shader()
+	bool Shader::loadBinary(uint64_t key)
 	{
-		// Cleanup
-		glUseProgram(0);
-		glDeleteProgram(m_program);
+		const BinaryFunctions& functions = getBinaryFunctions();
+		if (!functions.programBinary)
+			return false;
+
+		std::ifstream stream(getBinaryPath(cacheDirectory, key), std::ios::binary);
+		if (stream.fail())
+			return false;
+
+		// Make sure the binary is the one we want
+		BinaryHeader header = {};
+		stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if (!stream || header.magic != binaryMagic || header.key != key)
+			return false;
+
+		std::vector<char> binary((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+		if (binary.empty())
+			return false;
+
+		functions.programBinary(m_program, static_cast<GLenum>(header.format), binary.data(), static_cast<GLsizei>(binary.size()));
+
+		// The driver rejects binaries it can't use anymore
+		GLint linked = GL_FALSE;
+		glGetProgramiv(m_program, GL_LINK_STATUS, &linked);
+		return linked == GL_TRUE;
+	}
+
+	void Shader::saveBinary(uint64_t key)
+	{
+		const BinaryFunctions& functions = getBinaryFunctions();
+		if (!functions.getProgramBinary)
+			return;
+
+		GLint length = 0;
+		glGetProgramiv(m_program, programBinaryLength, &length);
+		if (length <= 0)
+			return;
+
+		BinaryHeader header = {};
+		header.key = key;
+
+		std::vector<char> binary(static_cast<size_t>(length));
+		GLenum format = 0;
+		functions.getProgramBinary(m_program, length, &length, &format, binary.data());
+		header.format = static_cast<uint32_t>(format);
+
+		// A failed write only means compiling again next launch
+		std::ofstream stream(getBinaryPath(cacheDirectory, key), std::ios::binary);
+		if (stream.fail())
+			return;
+
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		stream.write(binary.data(), length);
 	}
 }
\ No newline at end of file
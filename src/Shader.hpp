@@ -8,18 +8,131 @@
 
 /** Includes. */
 #include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
 #include <glad\glad.h>
 
 namespace snk
 {
+	/**
+	 * @enum ShaderFeature
+	 * @brief Features a shader variant is compiled with. Each one is injected as a #define of the same name.
+	 */
+	enum class ShaderFeature : uint32_t
+	{
+		None = 0,
+		Instanced = 1 << 0,
+		Batched = 1 << 1,
+		Textured = 1 << 2,
+		AlphaTest = 1 << 3
+	};
+
+	/**
+	 * @brief Combine shader features.
+	 * @param First features.
+	 * @param Second features.
+	 * @return Both sets of features.
+	 */
+	inline ShaderFeature operator|(ShaderFeature a, ShaderFeature b)
+	{
+		return static_cast<ShaderFeature>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
+	}
+
+	/**
+	 * @brief Intersect shader features.
+	 * @param First features.
+	 * @param Second features.
+	 * @return Features in both sets.
+	 */
+	inline ShaderFeature operator&(ShaderFeature a, ShaderFeature b)
+	{
+		return static_cast<ShaderFeature>(static_cast<uint32_t>(a) & static_cast<uint32_t>(b));
+	}
+
+	/**
+	 * @brief Get if a set of features contains a feature.
+	 * @param Set of features.
+	 * @param Feature.
+	 * @return If the feature is in the set.
+	 */
+	inline bool hasFeature(ShaderFeature features, ShaderFeature feature)
+	{
+		return (features & feature) == feature;
+	}
+
+	/**
+	 * @struct ShaderUniform
+	 * @brief An active uniform outside of any uniform block.
+	 */
+	struct ShaderUniform
+	{
+		/** Name, without a trailing [0] for arrays. */
+		std::string name = "";
+
+		/** Location. */
+		GLint location = -1;
+
+		/** GL type. */
+		GLenum type = 0;
+
+		/** Number of array elements. */
+		GLint size = 0;
+
+		/** Is the uniform a sampler? */
+		bool sampler = false;
+	};
+
+	/**
+	 * @struct ShaderAttribute
+	 * @brief An active vertex attribute.
+	 */
+	struct ShaderAttribute
+	{
+		/** Name. */
+		std::string name = "";
+
+		/** Location. */
+		GLint location = -1;
+
+		/** GL type. */
+		GLenum type = 0;
+
+		/** Number of array elements. */
+		GLint size = 0;
+	};
+
+	/**
+	 * @struct ShaderBlock
+	 * @brief An active uniform block.
+	 */
+	struct ShaderBlock
+	{
+		/** Name. */
+		std::string name = "";
+
+		/** Block index. */
+		GLuint index = GL_INVALID_INDEX;
+
+		/** Size of the block in bytes. */
+		GLint dataSize = 0;
+	};
+
 	/**
 	 * @class Shader
 	 * @brief Describes how a mesh looks.
+	 * @note Active uniforms, attributes, and uniform blocks are reflected once after linking,
+	 *		 so nothing has to be queried from GL by name afterwards.
+	 *		 Variants of a shader are compiled from the same sources on first use and cached
+	 *		 by their features. A feature is supported if a preprocessor conditional in the sources tests its name.
 	 */
 	class Shader
 	{
 	public:
 
+		/** Uniform buffer binding of the Camera block. */
+		static constexpr GLuint cameraBinding = 0;
+
 		/**
 		 * @brief Default constructor.
 		 */
@@ -34,9 +147,22 @@ namespace snk
 
 		/**
 		 * @brief Destructor.
+		 * @note While the engine runs, hand shaders to Renderer::retire() instead, so the
+		 *		 render thread forgets their cached uniforms before GL can reuse the IDs.
 		 */
 		~Shader();
 
+		/**
+		 * @brief Set the directory linked program binaries are cached in.
+		 * @param Directory, ending in a path separator. Empty disables the cache.
+		 * @note Binaries are keyed by the shader sources and the GL driver, so a driver
+		 *		 update or an edited shader falls back to compiling from source.
+		 */
+		static inline void setCacheDirectory(const std::string& directory)
+		{
+			cacheDirectory = directory;
+		}
+
 		/**
 		 * @brief Get shader program.
 		 * @return Shader program.
@@ -46,9 +172,214 @@ namespace snk
 			return m_program;
 		}
 
+		/**
+		 * @brief Get the features the shader was compiled with.
+		 * @return Features.
+		 */
+		inline ShaderFeature getFeatures() const
+		{
+			return m_features;
+		}
+
+		/**
+		 * @brief Get the features the sources can be compiled with.
+		 * @return Supported features.
+		 */
+		inline ShaderFeature getSupportedFeatures() const
+		{
+			return m_supportedFeatures;
+		}
+
+		/**
+		 * @brief Get a variant of the shader.
+		 * @param Features of the variant. Unsupported features are ignored.
+		 * @return Variant, compiled on first use. Owned by the shader it was created from.
+		 * @note Render thread only.
+		 */
+		Shader* getVariant(ShaderFeature features);
+
+		/**
+		 * @brief Get the program of the shader and of every variant compiled so far.
+		 * @param Vector to append the programs to.
+		 * @note Render thread only.
+		 */
+		void getPrograms(std::vector<GLuint>& programs) const;
+
+		/**
+		 * @brief Find an active uniform.
+		 * @param Uniform name.
+		 * @return Uniform or nullptr if the shader has no such uniform.
+		 */
+		const ShaderUniform* findUniform(const std::string& name) const;
+
+		/**
+		 * @brief Find an active vertex attribute.
+		 * @param Attribute name.
+		 * @return Attribute or nullptr if the shader has no such attribute.
+		 */
+		const ShaderAttribute* findAttribute(const std::string& name) const;
+
+		/**
+		 * @brief Find an active uniform block.
+		 * @param Block name.
+		 * @return Block or nullptr if the shader has no such block.
+		 */
+		const ShaderBlock* findBlock(const std::string& name) const;
+
+		/**
+		 * @brief Get every active uniform outside of a uniform block.
+		 * @return Uniforms.
+		 */
+		inline const std::vector<ShaderUniform>& getUniforms() const
+		{
+			return m_uniforms;
+		}
+
+		/**
+		 * @brief Get every active vertex attribute.
+		 * @return Attributes.
+		 */
+		inline const std::vector<ShaderAttribute>& getAttributes() const
+		{
+			return m_attributes;
+		}
+
+		/**
+		 * @brief Get every active uniform block.
+		 * @return Uniform blocks.
+		 */
+		inline const std::vector<ShaderBlock>& getBlocks() const
+		{
+			return m_blocks;
+		}
+
+		/**
+		 * @brief Get the location of the modelBasis uniform.
+		 * @return Location, or -1 if the shader has none.
+		 */
+		inline GLint getModelBasisLocation() const
+		{
+			return m_modelBasisLocation;
+		}
+
+		/**
+		 * @brief Get the location of the modelTranslation uniform.
+		 * @return Location, or -1 if the shader has none.
+		 */
+		inline GLint getModelTranslationLocation() const
+		{
+			return m_modelTranslationLocation;
+		}
+
+		/**
+		 * @brief Get the location of the tint uniform.
+		 * @return Location, or -1 if the shader has none.
+		 */
+		inline GLint getTintLocation() const
+		{
+			return m_tintLocation;
+		}
+
 	private:
 
+		/** Directory program binaries are cached in. */
+		static std::string cacheDirectory;
+
+		/**
+		 * @brief Variant constructor.
+		 * @param Shader the variant belongs to.
+		 * @param Features of the variant.
+		 */
+		Shader(Shader* root, ShaderFeature features);
+
+		/**
+		 * @brief Compile, or load from the binary cache, and reflect the program.
+		 * @param Vertex shader source.
+		 * @param Fragment shader source.
+		 */
+		void build(const std::string& vertexSource, const std::string& fragmentSource);
+
+		/**
+		 * @brief Add a #define for every feature after the #version line of a source.
+		 * @param Source.
+		 * @param Features.
+		 * @return Source with the defines.
+		 */
+		static std::string injectDefines(const std::string& source, ShaderFeature features);
+
+		/**
+		 * @brief Compile and link the program from source.
+		 * @param Vertex shader source.
+		 * @param Fragment shader source.
+		 * @return If the program linked.
+		 */
+		bool compile(const std::string& vertexSource, const std::string& fragmentSource);
+
+		/**
+		 * @brief Load the program from the binary cache.
+		 * @param Cache key.
+		 * @return If a matching binary was found and linked.
+		 */
+		bool loadBinary(uint64_t key);
+
+		/**
+		 * @brief Save the linked program to the binary cache.
+		 * @param Cache key.
+		 */
+		void saveBinary(uint64_t key);
+
+		/**
+		 * @brief Read the active uniforms, attributes, and uniform blocks of the program.
+		 */
+		void reflect();
+
 		/** Shader program. */
 		GLuint m_program;
+
+		/** Active uniforms. */
+		std::vector<ShaderUniform> m_uniforms = {};
+
+		/** Active attributes. */
+		std::vector<ShaderAttribute> m_attributes = {};
+
+		/** Active uniform blocks. */
+		std::vector<ShaderBlock> m_blocks = {};
+
+		/** Uniform name to index. */
+		std::unordered_map<std::string, size_t> m_uniformIndices = {};
+
+		/** Attribute name to index. */
+		std::unordered_map<std::string, size_t> m_attributeIndices = {};
+
+		/** Uniform block name to index. */
+		std::unordered_map<std::string, size_t> m_blockIndices = {};
+
+		/** Location of the modelBasis uniform. */
+		GLint m_modelBasisLocation = -1;
+
+		/** Location of the modelTranslation uniform. */
+		GLint m_modelTranslationLocation = -1;
+
+		/** Location of the tint uniform. */
+		GLint m_tintLocation = -1;
+
+		/** Features the program was compiled with. */
+		ShaderFeature m_features = ShaderFeature::None;
+
+		/** Features the sources can be compiled with. */
+		ShaderFeature m_supportedFeatures = ShaderFeature::None;
+
+		/** Shader the variant belongs to, or nullptr if this isn't a variant. */
+		Shader* m_root = nullptr;
+
+		/** Vertex shader source. Only kept by shaders that aren't variants. */
+		std::string m_vertexSource = "";
+
+		/** Fragment shader source. Only kept by shaders that aren't variants. */
+		std::string m_fragmentSource = "";
+
+		/** Variants by features. */
+		std::unordered_map<uint32_t, std::unique_ptr<Shader>> m_variants = {};
+
 	};
 }
\ No newline at end of file
@@ -3,11 +3,24 @@
 out vec4 outColor;
 
 in vec2 UV;
+in vec4 Tint;
 
+#ifdef TEXTURED
 uniform sampler2D sprite;
+#endif
+
 uniform vec4 color;
 
 void main()
 {
-	outColor = texture(sprite, UV) * color;
+#ifdef TEXTURED
+	outColor = texture(sprite, UV) * color * Tint;
+#else
+	outColor = color * Tint;
+#endif
+
+#ifdef ALPHA_TEST
+	if (outColor.a < 0.5)
+		discard;
+#endif
 }
\ No newline at end of file
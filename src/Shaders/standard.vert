@@ -1,14 +1,55 @@
 #version 330 core
 
+#if defined(INSTANCED)
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inUV;
+layout(location = 2) in vec4 instanceBasis;
+layout(location = 3) in vec3 instanceTranslation;
+layout(location = 4) in vec4 instanceColor;
+#elif defined(BATCHED)
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec2 inUV;
+layout(location = 2) in vec4 inColor;
+#else
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inUV;
+#endif
 
 out vec2 UV;
+out vec4 Tint;
+
+layout(std140) uniform Camera
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 time;
+};
 
-uniform mat4 MVP;
+#if !defined(INSTANCED) && !defined(BATCHED)
+uniform vec4 modelBasis;
+uniform vec3 modelTranslation;
+uniform vec4 tint;
+#endif
+
+// Apply a 2D affine transformation whose x and y axes are packed in basis
+vec4 place(vec2 position, vec4 basis, vec3 translation)
+{
+	return vec4((basis.xy * position.x) + (basis.zw * position.y) + translation.xy, translation.z, 1);
+}
 
 void main()
 {
 	UV = inUV;
-	gl_Position = MVP * vec4(inPosition, 1);
+
+#if defined(INSTANCED)
+	Tint = instanceColor;
+	gl_Position = viewProjection * place(inPosition, instanceBasis, instanceTranslation);
+#elif defined(BATCHED)
+	Tint = inColor;
+	gl_Position = viewProjection * vec4(inPosition, 1);
+#else
+	Tint = tint;
+	gl_Position = viewProjection * place(inPosition, modelBasis, modelTranslation);
+#endif
 }
\ No newline at end of file
@@ -1,16 +1,106 @@
 #define STB_IMAGE_IMPLEMENTATION
+#include <iostream>
+#include <algorithm>
 #include <stb_image.h>
 
 #include "Sprite.hpp"
 
 namespace snk
 {
+	std::atomic<GLuint> Sprite::placeholderTexture = { 0 };
+
+	std::vector<Sprite*> Sprite::pending = {};
+
+	std::mutex Sprite::pendingMutex;
+
+
+
 	Sprite::Sprite(const std::string& path, TextureFiltering filtering, TextureWrap wrap) : m_filtering(filtering), m_wrap(wrap)
 	{
 		// Load image
 		int width = 0, height = 0, nrChannels = 0;
 		unsigned char *data = stbi_load(path.c_str(), &width, &height, &nrChannels, STBI_rgb_alpha);
 
+		// Keep the placeholder if the image couldn't be read
+		if (data == nullptr)
+		{
+			std::cout << "Sprite: Failed to load " << path << " (" << stbi_failure_reason() << ")\n";
+			return;
+		}
+
+		upload(data, width, height);
+
+		// Free memory
+		stbi_image_free(data);
+	}
+
+	Sprite::Sprite(const std::string& path, TextureFiltering filtering, TextureWrap wrap, ThreadPool& threadPool) : m_threadPool(&threadPool), m_filtering(filtering), m_wrap(wrap)
+	{
+		threadPool.addJob([this, path]()
+		{
+			int nrChannels = 0;
+			unsigned char* data = stbi_load(path.c_str(), &m_decodedWidth, &m_decodedHeight, &nrChannels, STBI_rgb_alpha);
+
+			// Keep the placeholder if the image couldn't be read
+			if (data == nullptr)
+			{
+				std::cout << "Sprite: Failed to load " << path << " (" << stbi_failure_reason() << ")\n";
+				return;
+			}
+
+			// Hand the pixels to the render thread
+			std::lock_guard<std::mutex> lock(pendingMutex);
+			m_pixels = data;
+			pending.push_back(this);
+		}, &m_decoding);
+	}
+
+	Sprite::~Sprite()
+	{
+		if (m_threadPool)
+		{
+			m_threadPool->wait(m_decoding);
+
+			// Never uploaded
+			std::lock_guard<std::mutex> lock(pendingMutex);
+			pending.erase(std::remove(pending.begin(), pending.end(), this), pending.end());
+			stbi_image_free(m_pixels);
+		}
+
+		glDeleteTextures(1, &m_texID);
+	}
+
+	void Sprite::uploadPending()
+	{
+		if (placeholderTexture.load(std::memory_order_relaxed) == 0)
+		{
+			const unsigned char white[] = { 255, 255, 255, 255 };
+			GLuint placeholder = 0;
+
+			glGenTextures(1, &placeholder);
+			glBindTexture(GL_TEXTURE_2D, placeholder);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			placeholderTexture.store(placeholder, std::memory_order_relaxed);
+		}
+
+		// Sprites can't be destroyed while they're uploading
+		std::lock_guard<std::mutex> lock(pendingMutex);
+		for (auto sprite : pending)
+		{
+			sprite->upload(sprite->m_pixels, sprite->m_decodedWidth, sprite->m_decodedHeight);
+			stbi_image_free(sprite->m_pixels);
+			sprite->m_pixels = nullptr;
+		}
+
+		pending.clear();
+	}
+
+	void Sprite::upload(const unsigned char* pixels, int width, int height)
+	{
 		m_width = static_cast<uint32_t>(width);
 		m_height = static_cast<uint32_t>(height);
 
@@ -27,16 +117,10 @@ namespace snk
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, static_cast<GLint>(m_filtering));
 
 		// Bind data to texture
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
 		glGenerateMipmap(GL_TEXTURE_2D);
 		glBindTexture(GL_TEXTURE_2D, 0);
 
-		// Free memory
-		stbi_image_free(data);
-	}
-
-	Sprite::~Sprite()
-	{
-		glDeleteTextures(1, &m_texID);
+		m_loaded.store(true, std::memory_order_release);
 	}
 }
\ No newline at end of file
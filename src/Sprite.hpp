@@ -7,8 +7,12 @@
  */
 
 /** Includes. */
+#include <mutex>
+#include <atomic>
 #include <string>
+#include <vector>
 #include <glad\glad.h>
+#include "ThreadPool.hpp"
 
 namespace snk
 {
@@ -35,6 +39,9 @@ namespace snk
 	/**
 	 * @class Sprite.
 	 * @brief Stores 2D image data.
+	 * @note Sprites loaded through a thread pool decode their image on the pool and are
+	 *		 uploaded by the render thread at the start of the next frame. Until then they
+	 *		 sample a 1x1 white placeholder texture, which is also kept if the image fails to load.
 	 */
 	class Sprite
 	{
@@ -53,18 +60,48 @@ namespace snk
 		 */
 		Sprite(const std::string& path, TextureFiltering filtering, TextureWrap wrap);
 
+		/**
+		 * @brief Asynchronous constructor.
+		 * @param Path to an image file.
+		 * @param Requested filtering.
+		 * @param Requested tiling.
+		 * @param Thread pool to decode the image on.
+		 * @note Makes no GL calls, so it can be used from any thread.
+		 */
+		Sprite(const std::string& path, TextureFiltering filtering, TextureWrap wrap, ThreadPool& threadPool);
+
 		/**
 		 * @brief Destructor.
+		 * @note Waits for the image to finish decoding.
 		 */
 		~Sprite();
 
+		Sprite(const Sprite&) = delete;
+
+		Sprite& operator=(const Sprite&) = delete;
+
+		/**
+		 * @brief Upload every decoded sprite waiting for the render thread.
+		 * @note Used internally. Do not call.
+		 */
+		static void uploadPending();
+
 		/**
 		 * @brief Get texture.
-		 * @return Texture.
+		 * @return Texture, or the placeholder texture if the sprite isn't uploaded yet.
 		 */
 		inline GLuint getTexture() const
 		{
-			return m_texID;
+			return m_loaded.load(std::memory_order_acquire) ? m_texID : placeholderTexture.load(std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief Get if the sprites texture has been uploaded.
+		 * @return If the sprite is loaded.
+		 */
+		inline bool isLoaded() const
+		{
+			return m_loaded.load(std::memory_order_acquire);
 		}
 
 		/**
@@ -87,7 +124,7 @@ namespace snk
 
 		/**
 		 * @brief Get width.
-		 * @return Width.
+		 * @return Width. Zero until the sprite is loaded.
 		 */
 		inline uint32_t getWidth() const
 		{
@@ -96,7 +133,7 @@ namespace snk
 
 		/**
 		 * @brief Get height.
-		 * @return Height.
+		 * @return Height. Zero until the sprite is loaded.
 		 */
 		inline uint32_t getHeight() const
 		{
@@ -105,6 +142,41 @@ namespace snk
 
 	private:
 
+		/**
+		 * @brief Create the texture from decoded pixels.
+		 * @param RGBA pixels, or nullptr if decoding failed.
+		 * @param Image width.
+		 * @param Image height.
+		 */
+		void upload(const unsigned char* pixels, int width, int height);
+
+		/** 1x1 white texture sampled by sprites that aren't loaded. Created on the render thread. */
+		static std::atomic<GLuint> placeholderTexture;
+
+		/** Decoded sprites waiting to be uploaded. */
+		static std::vector<Sprite*> pending;
+
+		/** Guards the pending sprites and their uploads. */
+		static std::mutex pendingMutex;
+
+		/** Thread pool decoding the image, or nullptr if it was loaded synchronously. */
+		ThreadPool* m_threadPool = nullptr;
+
+		/** Tracks the decode job. */
+		JobCounter m_decoding = {};
+
+		/** Decoded pixels waiting to be uploaded. */
+		unsigned char* m_pixels = nullptr;
+
+		/** Decoded width. */
+		int m_decodedWidth = 0;
+
+		/** Decoded height. */
+		int m_decodedHeight = 0;
+
+		/** Has the texture been uploaded? */
+		std::atomic<bool> m_loaded = { false };
+
 		/** Texture filtering. */
 		TextureFiltering m_filtering = TextureFiltering::Linear;
 
@@ -0,0 +1,126 @@
+#include "SpriteBatch.hpp"
+#include "Renderer.hpp"
+
+namespace snk
+{
+	SpriteBatch::SpriteBatch(GLState* state) : m_state(state)
+	{
+		m_vertices.resize(maxVertices);
+		m_indices.resize(maxIndices);
+
+		glGenVertexArrays(1, &m_vao);
+		m_state->bindVertexArray(m_vao);
+
+		glGenBuffers(1, &m_vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+		glBufferData(GL_ARRAY_BUFFER, maxVertices * sizeof(BatchVertex), nullptr, GL_STREAM_DRAW);
+
+		glGenBuffers(1, &m_ebo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, maxIndices * sizeof(uint32_t), nullptr, GL_STREAM_DRAW);
+
+		// Position, UV, and color
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), (GLvoid*)0);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), (GLvoid*)(3 * sizeof(float)));
+		glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), (GLvoid*)(5 * sizeof(float)));
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+		glEnableVertexAttribArray(2);
+
+		m_state->bindVertexArray(0);
+	}
+
+	SpriteBatch::~SpriteBatch()
+	{
+		// Cleanup
+		glDeleteBuffers(1, &m_vbo);
+		glDeleteBuffers(1, &m_ebo);
+		glDeleteVertexArrays(1, &m_vao);
+	}
+
+	bool SpriteBatch::canBatch(const MeshData& mesh, const MaterialState& material)
+	{
+		return hasFeature(material.layout->shader->getSupportedFeatures(), ShaderFeature::Batched) &&
+			mesh.mesh->getVertices().size() <= maxMeshVertices &&
+			mesh.mesh->getIndexCount() <= maxMeshIndices;
+	}
+
+	void SpriteBatch::begin()
+	{
+		m_material = nullptr;
+		m_vertexCount = 0;
+		m_indexCount = 0;
+	}
+
+	void SpriteBatch::add(const MeshData& mesh, const MaterialState& material)
+	{
+		const auto& positions = mesh.mesh->getVertices();
+		const auto& uvs = mesh.mesh->getUVs();
+		const auto& indices = mesh.mesh->getIndices();
+
+		if (&material != m_material || m_vertexCount + positions.size() > maxVertices || m_indexCount + indices.size() > maxIndices)
+		{
+			flush();
+			m_material = &material;
+		}
+
+		// Flat meshes only need the 2D part, plus the depth offset
+		float a = mesh.model.basis.x;
+		float b = mesh.model.basis.y;
+		float c = mesh.model.basis.z;
+		float d = mesh.model.basis.w;
+		float tx = mesh.model.translation.x;
+		float ty = mesh.model.translation.y;
+		float tz = mesh.model.translation.z;
+
+		BatchVertex* vertices = &m_vertices[m_vertexCount];
+		for (size_t i = 0; i < positions.size(); i++)
+		{
+			vertices[i].position.x = (a * positions[i].x) + (c * positions[i].y) + tx;
+			vertices[i].position.y = (b * positions[i].x) + (d * positions[i].y) + ty;
+			vertices[i].position.z = tz;
+			vertices[i].uv = uvs[i];
+			vertices[i].color = mesh.color;
+		}
+
+		uint32_t* batchIndices = &m_indices[m_indexCount];
+		uint32_t base = static_cast<uint32_t>(m_vertexCount);
+		for (size_t i = 0; i < indices.size(); i++)
+			batchIndices[i] = indices[i] + base;
+
+		m_vertexCount += positions.size();
+		m_indexCount += indices.size();
+	}
+
+	void SpriteBatch::flush()
+	{
+		if (m_indexCount == 0)
+			return;
+
+		m_material->use(*m_state, m_material->layout->shader->getVariant(m_material->features | ShaderFeature::Batched));
+
+		// The element buffer is bound through the VAO
+		m_state->bindVertexArray(m_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+
+		// Start over with fresh storage once the ring is full so in flight draws keep theirs
+		if (m_vertexOffset + m_vertexCount > maxVertices || m_indexOffset + m_indexCount > maxIndices)
+		{
+			glBufferData(GL_ARRAY_BUFFER, maxVertices * sizeof(BatchVertex), nullptr, GL_STREAM_DRAW);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, maxIndices * sizeof(uint32_t), nullptr, GL_STREAM_DRAW);
+
+			m_vertexOffset = 0;
+			m_indexOffset = 0;
+		}
+
+		glBufferSubData(GL_ARRAY_BUFFER, m_vertexOffset * sizeof(BatchVertex), m_vertexCount * sizeof(BatchVertex), m_vertices.data());
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, m_indexOffset * sizeof(uint32_t), m_indexCount * sizeof(uint32_t), m_indices.data());
+
+		glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(m_indexCount), GL_UNSIGNED_INT, (GLvoid*)(m_indexOffset * sizeof(uint32_t)), static_cast<GLint>(m_vertexOffset));
+
+		m_vertexOffset += m_vertexCount;
+		m_indexOffset += m_indexCount;
+		m_vertexCount = 0;
+		m_indexCount = 0;
+	}
+}
\ No newline at end of file
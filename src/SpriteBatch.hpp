@@ -0,0 +1,131 @@
+#pragma once
+
+/**
+ * @file SpriteBatch.hpp
+ * @brief Sprite batch header file.
+ * @author Connor J. Bramham (ReeCocho)
+ */
+
+/** Includes. */
+#include <vector>
+#include <glm\glm.hpp>
+#include <glad\glad.h>
+#include "Material.hpp"
+#include "Mesh.hpp"
+#include "GLState.hpp"
+
+namespace snk
+{
+	struct MeshData;
+
+	/**
+	 * @struct BatchVertex
+	 * @brief Vertex of a batched sprite, already in world space.
+	 */
+	struct BatchVertex
+	{
+		/** Position, with depth in z. */
+		glm::vec3 position = {};
+
+		/** UV. */
+		glm::vec2 uv = {};
+
+		/** Color. */
+		glm::vec4 color = {};
+	};
+
+	/**
+	 * @class SpriteBatch
+	 * @brief Merges small meshes into one draw call by transforming their vertices on the CPU.
+	 * @note Vertices stream into a ring buffer that is orphaned when it wraps. A batch is
+	 *		 flushed when the material changes, when it is full, or when something else draws.
+	 */
+	class SpriteBatch
+	{
+	public:
+
+		/** Maximum number of vertices in the ring buffer. */
+		static constexpr size_t maxVertices = 65536;
+
+		/** Maximum number of indices in the ring buffer. */
+		static constexpr size_t maxIndices = 98304;
+
+		/** Largest mesh, in vertices, worth batching. */
+		static constexpr size_t maxMeshVertices = 16;
+
+		/** Largest mesh, in indices, worth batching. Always below maxIndices. */
+		static constexpr size_t maxMeshIndices = 96;
+
+		/**
+		 * @brief Constructor.
+		 * @param GL state cache of the render thread.
+		 * @note Must be created on the render thread.
+		 */
+		SpriteBatch(GLState* state);
+
+		/**
+		 * @brief Destructor.
+		 */
+		~SpriteBatch();
+
+		/**
+		 * @brief Get if a mesh can be batched.
+		 * @param Mesh.
+		 * @param Material values the mesh was drawn with.
+		 * @return If the mesh has few enough vertices and indices, and its shader has a batched variant.
+		 */
+		static bool canBatch(const MeshData& mesh, const MaterialState& material);
+
+		/**
+		 * @brief Start batching a frame.
+		 */
+		void begin();
+
+		/**
+		 * @brief Add a mesh to the batch.
+		 * @param Mesh. Must be batchable.
+		 * @param Material values the mesh was drawn with. Must stay alive until the batch is flushed.
+		 */
+		void add(const MeshData& mesh, const MaterialState& material);
+
+		/**
+		 * @brief Draw everything in the batch.
+		 */
+		void flush();
+
+	private:
+
+		/** GL state cache. */
+		GLState* m_state = nullptr;
+
+		/** Vertex attribute object. */
+		GLuint m_vao = 0;
+
+		/** Vertex buffer object. */
+		GLuint m_vbo = 0;
+
+		/** Element buffer object. */
+		GLuint m_ebo = 0;
+
+		/** Material values of the batch. */
+		const MaterialState* m_material = nullptr;
+
+		/** Vertices of the batch. */
+		std::vector<BatchVertex> m_vertices = {};
+
+		/** Indices of the batch, relative to the first vertex of the batch. */
+		std::vector<uint32_t> m_indices = {};
+
+		/** Number of vertices in the batch. */
+		size_t m_vertexCount = 0;
+
+		/** Number of indices in the batch. */
+		size_t m_indexCount = 0;
+
+		/** Vertex the next batch is written to in the ring buffer. */
+		size_t m_vertexOffset = 0;
+
+		/** Index the next batch is written to in the ring buffer. */
+		size_t m_indexOffset = 0;
+	};
+}
\ No newline at end of file
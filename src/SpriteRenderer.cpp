@@ -5,26 +5,26 @@ namespace snk
 {
 	SpriteRenderer::SpriteRenderer(Scene* scene, Entity entity, ComponentID id) : Component(scene, entity, id)
 	{
-		setRunOnBegin(true);
-		setRunOnPreRender(true);
-	}
 
-	void SpriteRenderer::onBegin()
-	{
-		m_transform = getEntity().getComponent<Transform>();
 	}
 
-	void SpriteRenderer::onPreRender(float deltaTime)
+	void SpriteRenderer::drawSprites(Scene* scene)
 	{
-		if (m_mesh && m_material)
+		Renderer* renderer = Engine::get()->getRenderer();
+
+		scene->query<Transform, SpriteRenderer>().each([renderer](Transform& transform, SpriteRenderer& sprite)
 		{
-			MeshData data = {};
-			data.material = m_material;
-			data.mesh = m_mesh;
-			data.depth = m_depth;
-			data.model = m_transform->getModelMatrix();
+			if (sprite.getRunOnPreRender() && sprite.m_mesh && sprite.m_material)
+			{
+				MeshData data = {};
+				data.material = sprite.m_material;
+				data.mesh = sprite.m_mesh;
+				data.depth = sprite.m_depth;
+				data.color = sprite.m_color;
+				data.model = transform.getModel();
 
-			Engine::get()->getRenderer()->draw(data);
-		}
+				renderer->draw(data);
+			}
+		});
 	}
 }
\ No newline at end of file
@@ -32,16 +32,11 @@ namespace snk
 		~SpriteRenderer() = default;
 
 		/**
-		 * @brief Called when the component is added to a game object.
-		 * @note Please use this for memory aquisition.
+		 * @brief Submit every sprite in a scene to the renderer.
+		 * @param Scene to draw.
+		 * @note Registered as a pre-render system by the engine.
 		 */
-		void onBegin() override;
-
-		/**
-		 * @brief Called once per tick after onLateTick() but before presenting.
-		 * @param Time in seconds since last tick.
-		 */
-		void onPreRender(float deltaTime) override;
+		static void drawSprites(Scene* scene);
 
 		/**
 		 * @brief Set depth.
@@ -76,6 +71,17 @@ namespace snk
 			return m_material;
 		}
 
+		/**
+		 * @brief Set color.
+		 * @param New color.
+		 * @return New color.
+		 */
+		inline glm::vec4 setColor(glm::vec4 color)
+		{
+			m_color = color;
+			return m_color;
+		}
+
 		/**
 		 * @brief Get depth.
 		 * @return Depth.
@@ -103,10 +109,16 @@ namespace snk
 			return m_material;
 		}
 
-	private:
+		/**
+		 * @brief Get color.
+		 * @return Color.
+		 */
+		inline glm::vec4 getColor() const
+		{
+			return m_color;
+		}
 
-		/** Meshes transform. */
-		Transform* m_transform = nullptr;
+	private:
 
 		/** Mesh to render. */
 		Mesh* m_mesh = nullptr;
@@ -116,5 +128,8 @@ namespace snk
 
 		/** Mesh depth. */
 		uint32_t m_depth = 0;
+
+		/** Color to tint the sprite with. */
+		glm::vec4 m_color = glm::vec4(1, 1, 1, 1);
 	};
 }
\ No newline at end of file
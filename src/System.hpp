@@ -0,0 +1,105 @@
+#pragma once
+
+/**
+ * @file System.hpp
+ * @brief System header file.
+ * @author Connor J. Bramham (ReeCocho)
+ */
+
+/** Includes. */
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+namespace snk
+{
+	typedef size_t ComponentID;
+
+	/**
+	 * @enum SystemPhase
+	 * @brief Part of a scene tick a system runs in.
+	 */
+	enum class SystemPhase
+	{
+		Tick = 0,
+		LateTick = 1,
+		PreRender = 2
+	};
+
+	/**
+	 * @struct SystemAccess
+	 * @brief Component types a system reads and writes.
+	 * @note Systems without declared access are exclusive and never run alongside another system.
+	 */
+	struct SystemAccess
+	{
+		/** Component IDs the system reads. */
+		std::vector<ComponentID> reads = {};
+
+		/** Component IDs the system writes. */
+		std::vector<ComponentID> writes = {};
+
+		/** Does the system need to run alone? */
+		bool exclusive = true;
+
+		/**
+		 * @brief Declare component types the system reads.
+		 * @return This access.
+		 */
+		template<class... ComponentTypes>
+		SystemAccess& read();
+
+		/**
+		 * @brief Declare component types the system writes.
+		 * @return This access.
+		 */
+		template<class... ComponentTypes>
+		SystemAccess& write();
+
+		/**
+		 * @brief Get if two systems can't run at the same time.
+		 * @param Other systems access.
+		 * @return If either system writes something the other touches.
+		 */
+		inline bool conflictsWith(const SystemAccess& other) const
+		{
+			if (exclusive || other.exclusive)
+				return true;
+
+			auto overlaps = [](const std::vector<ComponentID>& a, const std::vector<ComponentID>& b)
+			{
+				for (auto id : a)
+					if (std::find(b.begin(), b.end(), id) != b.end())
+						return true;
+
+				return false;
+			};
+
+			return overlaps(writes, other.writes) || overlaps(writes, other.reads) || overlaps(reads, other.writes);
+		}
+	};
+
+	/**
+	 * @struct System
+	 * @brief Function run over whole component arrays once per tick.
+	 * @note Systems in a phase run after the component callbacks of that phase.
+	 * @see Scene
+	 */
+	struct System
+	{
+		/** Phase the system runs in. */
+		SystemPhase phase = SystemPhase::Tick;
+
+		/** Component types the system touches. */
+		SystemAccess access = {};
+
+		/** Function to run. Receives the delta time. */
+		std::function<void(float)> function = nullptr;
+	};
+
+	/**
+	 * @typedef SystemBatch
+	 * @brief Indices of systems in a phase that can run at the same time.
+	 */
+	typedef std::vector<size_t> SystemBatch;
+}
\ No newline at end of file
@@ -16,77 +16,252 @@ namespace snk
 			{
 				std::lock_guard<std::mutex> lock(m_jobs_mutex);
 				m_destroying = true;
-				m_condition.notify_one();
+				m_condition.notify_all();
 			}
 
 			m_thread.join();
 		}
 	}
 
-	void WorkerThread::addJob(std::function<void(void)> job)
+	void WorkerThread::addJob(Job job)
 	{
+		addJobs(&job, 1);
+	}
+
+	void WorkerThread::addJobs(Job* jobs, size_t count)
+	{
+		if (count == 0)
+			return;
+
 		std::lock_guard<std::mutex> lock(m_jobs_mutex);
-		m_jobs.push(move(job));
-		m_condition.notify_one();
+		for (size_t i = 0; i < count; i++)
+			m_jobs.push_back(std::move(jobs[i]));
+
+		m_condition.notify_all();
 	}
 
 	void WorkerThread::wait()
 	{
 		std::unique_lock<std::mutex> lock(m_jobs_mutex);
-		m_condition.wait(lock, [this]() { return m_jobs.empty(); });
+		m_condition.wait(lock, [this]() { return m_jobs.empty() && !m_working; });
 	}
 
 	void WorkerThread::work()
 	{
+		Job job = {};
+
 		while (true)
 		{
-			std::function<void(void)> job;
 			{
 				std::unique_lock<std::mutex> lock(m_jobs_mutex);
+
+				// Report the last job as done
+				if (m_working)
+				{
+					m_working = false;
+					m_condition.notify_all();
+				}
+
 				m_condition.wait(lock, [this] { return !m_jobs.empty() || m_destroying; });
 
 				if (m_destroying)
 					break;
 
-				job = m_jobs.front();
+				job = m_jobs.pop_front();
+				m_working = true;
 			}
 
 			job();
+			job.reset();
+		}
+	}
+
+
+
+	/** Pool the calling thread works for. */
+	static thread_local ThreadPool* currentPool = nullptr;
+
+	/** Queue the calling thread owns in its pool. */
+	static thread_local size_t currentQueue = 0;
+
+
+
+	ThreadPool::ThreadPool() : m_queued(0), m_nextQueue(0), m_sleeping(0)
+	{
+		size_t threads = static_cast<size_t>(std::thread::hardware_concurrency());
+		start(threads > 1 ? threads - 1 : 1);
+	}
+
+	ThreadPool::ThreadPool(size_t threadCount) : m_queued(0), m_nextQueue(0), m_sleeping(0)
+	{
+		start(threadCount);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		wait();
+
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_destroying = true;
+			m_sleepCondition.notify_all();
+		}
+
+		for (auto& thread : m_threads)
+			thread.join();
+	}
+
+
+
+	void ThreadPool::addJob(Job job, JobCounter* counter)
+	{
+		addJobs(&job, 1, counter);
+	}
+
+	void ThreadPool::addJobs(Job* jobs, size_t count, JobCounter* counter)
+	{
+		if (count == 0)
+			return;
+
+		if (counter)
+			counter->count.fetch_add(count, std::memory_order_relaxed);
+
+		m_pending.count.fetch_add(count, std::memory_order_relaxed);
 
+		// Workers keep their jobs, other threads split the batch over every queue
+		size_t queues = currentPool == this ? 1 : std::min(count, m_queues.size());
+		size_t first = getQueueIndex();
+
+		for (size_t i = 0; i < queues; i++)
+		{
+			size_t begin = (count * i) / queues;
+			size_t end = (count * (i + 1)) / queues;
+
+			JobQueue* queue = m_queues[(first + i) % m_queues.size()].get();
+			std::lock_guard<std::mutex> lock(queue->mutex);
+
+			for (size_t j = begin; j < end; j++)
 			{
-				std::lock_guard<std::mutex> lock(m_jobs_mutex);
-				m_jobs.pop();
-				m_condition.notify_one();
+				JobRecord record = {};
+				record.job = std::move(jobs[j]);
+				record.counter = counter;
+				queue->jobs.push_back(std::move(record));
 			}
 		}
+
+		m_queued.fetch_add(count);
+		wake(count);
 	}
 
+	void ThreadPool::wait(JobCounter& counter)
+	{
+		size_t queue = currentPool == this ? currentQueue : 0;
 
+		while (!counter.isDone())
+			if (!runJob(queue))
+				std::this_thread::yield();
+	}
 
-	ThreadPool::ThreadPool()
+	void ThreadPool::wait()
 	{
-		
+		wait(m_pending);
 	}
 
-	ThreadPool::ThreadPool(size_t threadCount)
+	void ThreadPool::start(size_t threadCount)
 	{
+		for (size_t i = 0; i < std::max(threadCount, static_cast<size_t>(1)); i++)
+			m_queues.push_back(std::make_unique<JobQueue>());
+
 		for (size_t i = 0; i < threadCount; i++)
-			workers.push_back(new WorkerThread());
+			m_threads.push_back(std::thread(&ThreadPool::work, this, i));
 	}
 
-	ThreadPool::~ThreadPool()
+	void ThreadPool::wake(size_t count)
 	{
-		wait();
+		// Only touch the sleep mutex if a worker might be asleep
+		if (m_sleeping.load() == 0)
+			return;
+
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+
+		if (count >= m_threads.size())
+			m_sleepCondition.notify_all();
+		else
+			for (size_t i = 0; i < count; i++)
+				m_sleepCondition.notify_one();
+	}
 
-		for (size_t i = 0; i < workers.size(); i++)
-			delete workers[i];
+	size_t ThreadPool::getQueueIndex()
+	{
+		if (currentPool == this)
+			return currentQueue;
+
+		return m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
 	}
 
+	bool ThreadPool::runJob(size_t queue)
+	{
+		if (m_queued.load(std::memory_order_acquire) == 0)
+			return false;
 
+		JobRecord record = {};
+		bool found = false;
 
-	void ThreadPool::wait()
+		// Newest job of our own queue first
+		{
+			JobQueue* own = m_queues[queue].get();
+			std::lock_guard<std::mutex> lock(own->mutex);
+			if (!own->jobs.empty())
+			{
+				record = own->jobs.pop_back();
+				found = true;
+			}
+		}
+
+		// Then steal the oldest job of another queue
+		for (size_t i = 1; i < m_queues.size() && !found; i++)
+		{
+			JobQueue* victim = m_queues[(queue + i) % m_queues.size()].get();
+			std::lock_guard<std::mutex> lock(victim->mutex);
+			if (!victim->jobs.empty())
+			{
+				record = victim->jobs.pop_front();
+				found = true;
+			}
+		}
+
+		if (!found)
+			return false;
+
+		m_queued.fetch_sub(1, std::memory_order_relaxed);
+		record.job();
+		record.job.reset();
+
+		if (record.counter)
+			record.counter->count.fetch_sub(1, std::memory_order_release);
+
+		m_pending.count.fetch_sub(1, std::memory_order_release);
+		return true;
+	}
+
+	void ThreadPool::work(size_t index)
 	{
-		for (size_t i = 0; i < workers.size(); i++)
-			workers[i]->wait();
+		currentPool = this;
+		currentQueue = index;
+
+		while (true)
+		{
+			if (runJob(index))
+				continue;
+
+			// Announcing the sleep before checking for jobs pairs with wake()
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_sleeping.fetch_add(1);
+			m_sleepCondition.wait(lock, [this]() { return m_queued.load() > 0 || m_destroying; });
+			m_sleeping.fetch_sub(1);
+
+			if (m_destroying && m_queued.load(std::memory_order_acquire) == 0)
+				break;
+		}
 	}
 }
\ No newline at end of file
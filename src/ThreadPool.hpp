@@ -11,9 +11,10 @@
 #include <mutex>
 #include <atomic>
 #include <vector>
-#include <functional>
-#include <queue>
+#include <memory>
+#include <algorithm>
 #include <condition_variable>
+#include "Job.hpp"
 
 namespace snk
 {
@@ -38,8 +39,16 @@ namespace snk
 
 		/**
 		 * @brief Add a job to the worker thread.
+		 * @param Job to run.
 		 */
-		void addJob(std::function<void(void)> job);
+		void addJob(Job job);
+
+		/**
+		 * @brief Add several jobs to the worker thread at once.
+		 * @param Jobs to run. They are moved from.
+		 * @param Number of jobs.
+		 */
+		void addJobs(Job* jobs, size_t count);
 
 		/**
 		 * @brief Wait for the worker to finish working.
@@ -54,8 +63,11 @@ namespace snk
 		/** Thread object. */
 		std::thread m_thread;
 
+		/** Is the worker running a job? */
+		bool m_working = false;
+
 		/** Job queue. */
-		std::queue<std::function<void(void)>> m_jobs;
+		JobBuffer<Job> m_jobs;
 
 		/** Job queue mutex. */
 		std::mutex m_jobs_mutex;
@@ -69,17 +81,48 @@ namespace snk
 		void work();
 	};
 
+	/**
+	 * @struct JobCounter
+	 * @brief Counts unfinished jobs so they can be waited on as a group.
+	 * @see ThreadPool
+	 */
+	struct JobCounter
+	{
+		/**
+		 * @brief Default constructor.
+		 */
+		JobCounter() : count(0)
+		{
+
+		}
+
+		/**
+		 * @brief Get if every job added with the counter has finished.
+		 * @return If every job has finished.
+		 */
+		inline bool isDone() const
+		{
+			return count.load(std::memory_order_acquire) == 0;
+		}
+
+		/** Number of unfinished jobs. */
+		std::atomic<size_t> count;
+	};
+
 	/**
 	 * @class ThreadPool
-	 * @brief Manages worker threads.
-	 * @see WorkerThread
+	 * @brief Work stealing job scheduler.
+	 * @note Every worker owns a queue. Workers run their newest job first and steal the
+	 *		 oldest job of another worker when their own queue is empty. Threads waiting on
+	 *		 the pool run jobs instead of blocking.
 	 */
 	class ThreadPool
 	{
 	public:
 
 		/**
-		 * @brief Constructor.
+		 * @brief Default constructor.
+		 * @note Creates a worker for every hardware thread but the calling one.
 		 */
 		ThreadPool();
 
@@ -94,23 +137,167 @@ namespace snk
 		 */
 		~ThreadPool();
 
+		/**
+		 * @brief Add a job to the pool.
+		 * @param Job to run.
+		 * @param Counter to track the job with, or nullptr.
+		 * @note Jobs added from a worker go to its own queue, other threads spread jobs over every queue.
+		 */
+		void addJob(Job job, JobCounter* counter = nullptr);
+
+		/**
+		 * @brief Add several jobs to the pool at once.
+		 * @param Jobs to run. They are moved from.
+		 * @param Number of jobs.
+		 * @param Counter to track the jobs with, or nullptr.
+		 * @note Takes each queue lock once for the whole batch.
+		 */
+		void addJobs(Job* jobs, size_t count, JobCounter* counter = nullptr);
 
+		/**
+		 * @brief Run jobs until every job tracked by a counter has finished.
+		 * @param Counter to wait on.
+		 */
+		void wait(JobCounter& counter);
 
 		/**
 		 * @brief Wait for the thread pool to finish working.
 		 */
 		void wait();
 
+		/**
+		 * @brief Run a function over a range of indices in parallel.
+		 * @param First index.
+		 * @param One past the last index.
+		 * @param Number of indices per job, or 0 to split the range evenly over the threads.
+		 * @param Function taking the first and one past the last index of a sub range.
+		 * @note Returns once the whole range has been processed. The calling thread takes part.
+		 */
+		template<class Function>
+		void parallelFor(size_t begin, size_t end, size_t grainSize, Function function)
+		{
+			if (end <= begin)
+				return;
+
+			if (grainSize == 0)
+				grainSize = std::max(static_cast<size_t>(1), (end - begin) / ((getWorkerCount() + 1) * 4));
+
+			// Hand out every sub range but the first in batches and do the first one here
+			JobCounter counter;
+			Job jobs[64];
+			size_t count = 0;
+
+			for (size_t start = begin + grainSize; start < end; start += grainSize)
+			{
+				size_t stop = std::min(start + grainSize, end);
+				jobs[count++] = Job([&function, start, stop]() { function(start, stop); });
+
+				if (count == 64)
+				{
+					addJobs(jobs, count, &counter);
+					count = 0;
+				}
+			}
+
+			addJobs(jobs, count, &counter);
+
+			function(begin, std::min(begin + grainSize, end));
+			wait(counter);
+		}
+
 		/**
 		 * @brief Get number of worker threads.
 		 * @return Number of worker threads.
 		 */
 		inline size_t getWorkerCount() const
 		{
-			return workers.size();
+			return m_threads.size();
 		}
 
+	private:
+
+		/**
+		 * @struct JobRecord
+		 * @brief A queued job and the counter tracking it.
+		 */
+		struct JobRecord
+		{
+			/** Job to run. */
+			Job job = {};
+
+			/** Counter to decrement once the job is done. */
+			JobCounter* counter = nullptr;
+		};
+
+		/**
+		 * @struct JobQueue
+		 * @brief Jobs owned by one worker.
+		 */
+		struct JobQueue
+		{
+			/** Jobs. The owner uses the back, thieves use the front. */
+			JobBuffer<JobRecord> jobs = {};
+
+			/** Job mutex. */
+			std::mutex mutex;
+		};
+
 		/** Worker threads. */
-		std::vector<WorkerThread*> workers = {};	
+		std::vector<std::thread> m_threads = {};
+
+		/** Job queues. One per worker, or a single shared queue without workers. */
+		std::vector<std::unique_ptr<JobQueue>> m_queues = {};
+
+		/** Counter tracking every job in the pool. */
+		JobCounter m_pending;
+
+		/** Number of jobs waiting in queues. */
+		std::atomic<size_t> m_queued;
+
+		/** Queue the next job from outside the pool goes to. */
+		std::atomic<size_t> m_nextQueue;
+
+		/** Number of workers asleep or about to sleep. */
+		std::atomic<size_t> m_sleeping;
+
+		/** Is the pool being destroyed? */
+		bool m_destroying = false;
+
+		/** Mutex idle workers sleep on. */
+		std::mutex m_sleepMutex;
+
+		/** Condition idle workers sleep on. */
+		std::condition_variable m_sleepCondition;
+
+		/**
+		 * @brief Create the queues and workers.
+		 * @param Number of worker threads.
+		 */
+		void start(size_t threadCount);
+
+		/**
+		 * @brief Get the queue the calling thread owns.
+		 * @return Queue index, or the next queue in turn if the thread isn't a worker of this pool.
+		 */
+		size_t getQueueIndex();
+
+		/**
+		 * @brief Wake sleeping workers after jobs were queued.
+		 * @param Number of jobs queued.
+		 */
+		void wake(size_t count);
+
+		/**
+		 * @brief Run a single job.
+		 * @param Queue to take from first. Every other queue is stolen from afterwards.
+		 * @return If a job was run.
+		 */
+		bool runJob(size_t queue);
+
+		/**
+		 * @brief Work method.
+		 * @param Index of the workers queue.
+		 */
+		void work(size_t index);
 	};
 }
\ No newline at end of file
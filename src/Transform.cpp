@@ -1,101 +1,115 @@
 #include <algorithm>
 #include <glm\gtc\matrix_transform.hpp>
 #include "Transform.hpp"
+#include "Scene.hpp"
 
 namespace snk
 {
 	Transform::Transform(Scene* scene, Entity entity, ComponentID id) : Component(scene, entity, id)
 	{
+		setRunOnEnd(true);
+
+		m_hierarchy = &scene->getTransformHierarchy();
+		m_index = m_hierarchy->add(this);
 		m_parent = nullptr;
-		generateModelMatrix();
 	}
 
-	Transform::~Transform()
+	Transform::Transform(Transform&& other) :
+		Component(std::move(other)),
+		m_hierarchy(other.m_hierarchy),
+		m_index(other.m_index),
+		m_parent(other.m_parent),
+		m_children(std::move(other.m_children))
 	{
+		// Point the hierarchy at our new address
+		if (m_index != noRow)
+			m_hierarchy->m_owners[m_index] = this;
 
-	}
+		if (m_parent != nullptr)
+			std::replace(m_parent->m_children.begin(), m_parent->m_children.end(), &other, this);
 
+		for (auto child : m_children)
+			child->m_parent = this;
 
+		other.m_index = noRow;
+		other.m_parent = nullptr;
+		other.m_children.clear();
+	}
 
-	glm::vec3 Transform::setPosition(glm::vec3 value)
+	Transform::~Transform()
 	{
-		m_position = value;
+		if (m_index != noRow)
+			m_hierarchy->remove(m_index);
+	}
 
-		if (m_parent == nullptr)
-			m_localPosition = m_position;
-		else
+	void Transform::onEnd()
+	{
+		// Orphan children
+		auto children = m_children;
+		for (auto child : children)
+			child->setParent(nullptr);
+
+		// Remove self from parents child list
+		if (m_parent != nullptr)
 		{
-			glm::vec4 newPos = glm::inverse(m_parent->m_modelMatrix) * glm::vec4(m_position.x, m_position.y, m_position.z, 1.0);
-			m_localPosition = glm::vec3(newPos.x, newPos.y, newPos.z);
+			m_parent->m_children.erase(std::remove(m_parent->m_children.begin(), m_parent->m_children.end(), this), m_parent->m_children.end());
+			m_hierarchy->setParent(m_index, TransformHierarchy::noParent);
 		}
 
-		generateModelMatrix();
-		updateChildren();
-
-		return m_position;
+		m_parent = nullptr;
 	}
 
-	glm::vec3 Transform::setLocalPosition(glm::vec3 value)
-	{
-		m_localPosition = value;
 
+
+	glm::vec3 Transform::setPosition(glm::vec3 value)
+	{
 		if (m_parent == nullptr)
-			m_position = value;
+			m_hierarchy->setLocalPosition(m_index, value);
 		else
-		{
-			glm::vec4 newPos = m_parent->m_modelMatrix * glm::vec4(m_localPosition.x, m_localPosition.y, m_localPosition.z, 1.0);
-			m_position = glm::vec3(newPos.x, newPos.y, newPos.z);
-		}
+			m_hierarchy->setLocalPosition(m_index, m_parent->getModel().inverse().transformPoint(value));
 
-		generateModelMatrix();
-		updateChildren();
+		return value;
+	}
 
-		return m_localPosition;
+	glm::vec3 Transform::setLocalPosition(glm::vec3 value)
+	{
+		m_hierarchy->setLocalPosition(m_index, value);
+		return value;
 	}
 
 	float Transform::setRotation(float value)
 	{
-		m_rotation = value;
-
 		if (m_parent == nullptr)
-			m_localRotation = m_rotation;
+			m_hierarchy->setLocalRotation(m_index, value);
 		else
-			m_localRotation = m_rotation - m_parent->m_rotation;
-
-		generateModelMatrix();
-		updateChildren();
+			m_hierarchy->setLocalRotation(m_index, value - m_parent->getRotation());
 
-		return m_rotation;
+		return value;
 	}
 
 	float Transform::setLocalRotation(float value)
 	{
-		m_localRotation = value;
-
-		if (m_parent == nullptr)
-			m_rotation = m_localRotation;
-		else
-			m_rotation = m_parent->m_rotation + m_localRotation;
-
-		generateModelMatrix();
-		updateChildren();
-
-		return m_localRotation;
+		m_hierarchy->setLocalRotation(m_index, value);
+		return value;
 	}
 
 	glm::vec2 Transform::setLocalScale(glm::vec2 value)
 	{
-		m_localScale = value;
-		generateModelMatrix();
-		updateChildren();
-		return m_localScale;
+		m_hierarchy->setLocalScale(m_index, value);
+		return value;
 	}
 
 	Transform* Transform::setParent(Transform* parent)
 	{
+		assert(parent == nullptr || parent->m_hierarchy == m_hierarchy);
+
+		// Keep the world values under the new parent
+		glm::vec3 position = getPosition();
+		float rotation = getRotation();
+
 		// Remove self from parents child list
 		if (m_parent != nullptr)
-			parent->m_children.erase(std::remove(parent->m_children.begin(), parent->m_children.end(), this), parent->m_children.end());
+			m_parent->m_children.erase(std::remove(m_parent->m_children.begin(), m_parent->m_children.end(), this), m_parent->m_children.end());
 
 		// Set parent
 		m_parent = parent;
@@ -104,54 +118,12 @@ namespace snk
 		if (m_parent != nullptr)
 			parent->m_children.push_back(this);
 
-		// Update local values and model matrix
-		setPosition(getPosition());
-		setRotation(getRotation());
-
-		return m_parent;
-	}
-
-
-
-	void Transform::generateModelMatrix()
-	{
-		m_modelMatrix = {};
-		m_unscaledModelMatrix = {};
-
-		// Translation matrix
-		m_modelMatrix = glm::translate(m_modelMatrix, m_localPosition);
-
-		// Rotation matrix
-		m_modelMatrix = glm::rotate(m_modelMatrix, glm::radians(m_localRotation), glm::vec3(0, 0, 1));
-		m_unscaledModelMatrix = m_modelMatrix;
+		m_hierarchy->setParent(m_index, m_parent != nullptr ? m_parent->m_index : TransformHierarchy::noParent);
 
-		// Scale matrix
-		m_modelMatrix = glm::scale(m_modelMatrix, glm::vec3(m_localScale, 1));
+		// Update local values
+		setPosition(position);
+		setRotation(rotation);
 
-		// Get parent matrix if we have one
-		if (m_parent != nullptr)
-		{
-			m_modelMatrix = m_parent->m_unscaledModelMatrix * m_modelMatrix;
-			m_unscaledModelMatrix = m_parent->m_unscaledModelMatrix * m_unscaledModelMatrix;
-		}
-
-		// Update childrens model matrix
-		for (auto child : m_children)
-			child->generateModelMatrix();
-	}
-
-	void Transform::updateChildren()
-	{
-		for (auto child : m_children)
-		{
-			// Local position to global position
-			child->setLocalPosition(child->m_localPosition);
-
-			// Local euler angles to global euler angles
-			child->setLocalRotation(child->m_localRotation);
-
-			child->generateModelMatrix();
-			child->updateChildren();
-		}
+		return m_parent;
 	}
 }
\ No newline at end of file
@@ -10,15 +10,27 @@
 #include <glm\glm.hpp>
 #include <glm\gtc\quaternion.hpp>
 #include "Component.hpp"
+#include "Affine.hpp"
+#include "TransformHierarchy.hpp"
 
 namespace snk
 {
 	/**
 	 * @class Transform
 	 * @brief Describes the location in space of a game object.
+	 * @note Values live in a row of the scenes TransformHierarchy, and the local ones are the
+	 *		 source of truth. Setting one only flags the row, and world values are resolved on
+	 *		 first read or by the engine once per frame, so moving a parent many times costs
+	 *		 one subtree update.
+	 *		 Transforms of a scene have a single writer: any number of threads may read them at
+	 *		 once, but nothing may set, reparent, add, or remove a transform while they do.
+	 *		 Systems that write Transform are never scheduled next to systems that read it.
+	 * @see TransformHierarchy
 	 */
 	class Transform : public Component
 	{
+		friend class TransformHierarchy;
+
 	public:
 
 		/**
@@ -29,18 +41,32 @@ namespace snk
 		 */
 		Transform(Scene* scene, Entity entity, ComponentID id);
 
+		/**
+		 * @brief Move constructor.
+		 * @param Transform to move.
+		 * @note Used by the component pool. Relinks the parent, children, and row to the new address.
+		 */
+		Transform(Transform&& other);
+
 		/**
 		 * @brief Destructor.
+		 * @note Frees the row.
 		 */
 		~Transform();
 
+		/**
+		 * @brief Called when the component is removed from a game object.
+		 * @note Detaches the transform from its parent and children.
+		 */
+		void onEnd() override;
+
 		/**
 		 * @brief Get the transforms position.
 		 * @return Position.
 		 */
 		inline glm::vec3 getPosition() const
 		{
-			return m_position;
+			return m_hierarchy->getPosition(m_index);
 		}
 
 		/**
@@ -49,7 +75,7 @@ namespace snk
 		 */
 		inline glm::vec3 getLocalPosition() const
 		{
-			return m_localPosition;
+			return m_hierarchy->getLocalPosition(m_index);
 		}
 
 		/**
@@ -58,7 +84,7 @@ namespace snk
 		 */
 		inline float getRotation() const
 		{
-			return m_rotation;
+			return m_hierarchy->getRotation(m_index);
 		}
 
 		/**
@@ -67,7 +93,7 @@ namespace snk
 		 */
 		inline float getLocalRotation() const
 		{
-			return m_localRotation;
+			return m_hierarchy->m_localRotations[m_index];
 		}
 
 		/**
@@ -76,16 +102,26 @@ namespace snk
 		 */
 		inline glm::vec2 getLocalScale() const
 		{
-			return m_localScale;
+			return glm::vec2(m_hierarchy->m_localScalesX[m_index], m_hierarchy->m_localScalesY[m_index]);
+		}
+
+		/**
+		 * @brief Get the transforms model transformation.
+		 * @return Model transformation.
+		 */
+		inline Affine getModel() const
+		{
+			return m_hierarchy->getModel(m_index);
 		}
 
 		/**
 		 * @brief Get the transforms model matrix.
 		 * @return Model matrix.
+		 * @note Built from the model transformation on every call.
 		 */
 		inline glm::mat4 getModelMatrix() const
 		{
-			return m_modelMatrix;
+			return getModel().toMatrix();
 		}
 
 		/**
@@ -94,9 +130,8 @@ namespace snk
 		 */
 		inline glm::vec2 getUp() const
 		{
-			float x = glm::sin(glm::radians(m_rotation));
-			float y = glm::cos(glm::radians(m_rotation));
-			return glm::vec2(x, y);
+			glm::vec2 right = m_hierarchy->getRight(m_index);
+			return glm::vec2(right.y, right.x);
 		}
 
 		/**
@@ -105,9 +140,7 @@ namespace snk
 		 */
 		inline glm::vec2 getRight() const
 		{
-			float x = glm::cos(glm::radians(m_rotation));
-			float y = glm::sin(glm::radians(m_rotation));
-			return glm::vec2(x, y);
+			return m_hierarchy->getRight(m_index);
 		}
 
 		/**
@@ -191,7 +224,7 @@ namespace snk
 		 */
 		inline glm::vec3 modPosition(glm::vec3 value)
 		{
-			return setPosition(m_position + value);
+			return setPosition(getPosition() + value);
 		}
 
 		/**
@@ -201,7 +234,7 @@ namespace snk
 		 */
 		inline glm::vec3 modLocalPosition(glm::vec3 value)
 		{
-			return setLocalPosition(m_localPosition + value);
+			return setLocalPosition(getLocalPosition() + value);
 		}
 
 		/**
@@ -211,7 +244,7 @@ namespace snk
 		 */
 		inline float modRotation(float value)
 		{
-			return setRotation(m_rotation + value);
+			return setRotation(getRotation() + value);
 		}
 
 		/**
@@ -221,7 +254,7 @@ namespace snk
 		 */
 		inline float modLocalRotation(float value)
 		{
-			return setLocalRotation(m_localRotation + value);
+			return setLocalRotation(getLocalRotation() + value);
 		}
 
 		/**
@@ -231,7 +264,7 @@ namespace snk
 		 */
 		inline glm::vec2 modLocalScale(glm::vec2 value)
 		{
-			return setLocalScale(m_localScale + value);
+			return setLocalScale(getLocalScale() + value);
 		}
 
 		/**
@@ -246,36 +279,14 @@ namespace snk
 
 	private:
 
-		/**
-		 * @brief Generate a new model matrix.
-		 */
-		void generateModelMatrix();
-
-		/**
-		 * @brief Update the transforms children.
-		 */
-		void updateChildren();
-
-		/** Postion. */
-		glm::vec3 m_position = glm::vec3();
-
-		/** Local position. */
-		glm::vec3 m_localPosition = glm::vec3();
-
-		/** Local scale. */
-		glm::vec2 m_localScale = glm::vec2(1, 1);
-
-		/** Rotation. */
-		float m_rotation = 0;
-
-		/** Local rotation. */
-		float m_localRotation = 0;
+		/** Row index of a moved from transform. */
+		static constexpr uint32_t noRow = TransformHierarchy::noParent;
 
-		/** Model matrix. */
-		glm::mat4 m_modelMatrix = glm::mat4();
+		/** Hierarchy of the scene the transform is in. */
+		TransformHierarchy* m_hierarchy = nullptr;
 
-		/** Model matrix without scale applied (Used for hierarchy) */
-		glm::mat4 m_unscaledModelMatrix = glm::mat4();
+		/** Index of the transforms row, or noRow once moved from. */
+		uint32_t m_index = noRow;
 
 		/** Parent. */
 		Transform* m_parent = nullptr;
@@ -0,0 +1,317 @@
+#include <algorithm>
+#include "TransformHierarchy.hpp"
+#include "Transform.hpp"
+#include "ThreadPool.hpp"
+
+namespace snk
+{
+	/**
+	 * @brief Reorder an array.
+	 * @param Array to reorder.
+	 * @param Old index of every new index.
+	 */
+	template<class T>
+	static void permute(std::vector<T>& values, const std::vector<uint32_t>& order)
+	{
+		std::vector<T> permuted(order.size());
+
+		for (size_t i = 0; i < order.size(); i++)
+			permuted[i] = values[order[i]];
+
+		values.swap(permuted);
+	}
+
+
+
+	void TransformHierarchy::resolve(ThreadPool* threadPool)
+	{
+		if (m_structureDirty)
+			build();
+
+		if (!m_changed.load(std::memory_order_relaxed))
+			return;
+
+		// Each depth only reads the one before it
+		for (size_t depth = 0; depth < depthCount(); depth++)
+		{
+			size_t begin = m_depths[depth];
+			size_t end = m_depths[depth + 1];
+
+			if (threadPool == nullptr || end - begin <= grainSize)
+				resolveRange(begin, end);
+			else
+				threadPool->parallelFor(begin, end, grainSize, [this](size_t start, size_t stop) { resolveRange(start, stop); });
+		}
+
+		// Only cleared once every depth had the chance to inherit them
+		std::fill(m_dirty.begin(), m_dirty.end(), static_cast<uint8_t>(0));
+		m_changed.store(false, std::memory_order_relaxed);
+	}
+
+	uint32_t TransformHierarchy::add(Transform* owner)
+	{
+		uint32_t index = static_cast<uint32_t>(m_owners.size());
+
+		m_owners.push_back(owner);
+		m_parents.push_back(noParent);
+		m_dirty.push_back(0);
+		forEachArray([](std::vector<float>& values) { values.push_back(0); });
+
+		m_localCosines[index] = 1;
+		m_localScalesX[index] = 1;
+		m_localScalesY[index] = 1;
+		m_cosines[index] = 1;
+
+		m_structureDirty = true;
+		markDirty(index);
+		return index;
+	}
+
+	void TransformHierarchy::remove(uint32_t index)
+	{
+		m_owners[index] = nullptr;
+		m_parents[index] = noParent;
+		m_structureDirty = true;
+	}
+
+	void TransformHierarchy::setParent(uint32_t index, uint32_t parent)
+	{
+		m_parents[index] = parent;
+		m_structureDirty = true;
+		markDirty(index);
+	}
+
+	void TransformHierarchy::setLocalRotation(uint32_t index, float value)
+	{
+		float radians = glm::radians(value);
+		m_localRotations[index] = value;
+		m_localCosines[index] = glm::cos(radians);
+		m_localSines[index] = glm::sin(radians);
+		markDirty(index);
+	}
+
+	Affine TransformHierarchy::getModel(uint32_t index)
+	{
+		std::unique_lock<std::mutex> lock = resolveRow(index);
+
+		// Rotate then scale
+		Affine model = {};
+		model.basis = glm::vec4
+		(
+			m_cosines[index] * m_localScalesX[index],
+			m_sines[index] * m_localScalesX[index],
+			-m_sines[index] * m_localScalesY[index],
+			m_cosines[index] * m_localScalesY[index]
+		);
+		model.translation = glm::vec3(m_translationsX[index], m_translationsY[index], m_translationsZ[index]);
+		return model;
+	}
+
+	std::unique_lock<std::mutex> TransformHierarchy::resolveRow(uint32_t index)
+	{
+		if (!m_changed.load(std::memory_order_relaxed))
+			return std::unique_lock<std::mutex>();
+
+		bool changed = false;
+		for (uint32_t row = index; row != noParent && !changed; row = m_parents[row])
+			changed = m_dirty[row] != 0;
+
+		if (!changed)
+			return std::unique_lock<std::mutex>();
+
+		std::unique_lock<std::mutex> lock(m_resolveMutex);
+		resolveChain(index);
+		return lock;
+	}
+
+	bool TransformHierarchy::resolveChain(uint32_t index)
+	{
+		uint32_t parent = m_parents[index];
+		bool parentChanged = parent != noParent && resolveChain(parent);
+
+		if (!parentChanged && m_dirty[index] == 0)
+			return false;
+
+		float localX = m_localPositionsX[index];
+		float localY = m_localPositionsY[index];
+
+		if (parent == noParent)
+		{
+			m_translationsX[index] = localX;
+			m_translationsY[index] = localY;
+			m_translationsZ[index] = m_localPositionsZ[index];
+			m_positionsX[index] = localX;
+			m_positionsY[index] = localY;
+			m_rotations[index] = m_localRotations[index];
+			m_cosines[index] = m_localCosines[index];
+			m_sines[index] = m_localSines[index];
+			return true;
+		}
+
+		float cosine = m_cosines[parent];
+		float sine = m_sines[parent];
+
+		// Children are placed by their parents unscaled transformation...
+		m_translationsX[index] = m_translationsX[parent] + (cosine * localX) - (sine * localY);
+		m_translationsY[index] = m_translationsY[parent] + (sine * localX) + (cosine * localY);
+		m_translationsZ[index] = m_translationsZ[parent] + m_localPositionsZ[index];
+
+		// ...while their position goes through the scaled one
+		float scaledX = localX * m_localScalesX[parent];
+		float scaledY = localY * m_localScalesY[parent];
+		m_positionsX[index] = m_translationsX[parent] + (cosine * scaledX) - (sine * scaledY);
+		m_positionsY[index] = m_translationsY[parent] + (sine * scaledX) + (cosine * scaledY);
+
+		m_rotations[index] = m_rotations[parent] + m_localRotations[index];
+		m_cosines[index] = (cosine * m_localCosines[index]) - (sine * m_localSines[index]);
+		m_sines[index] = (sine * m_localCosines[index]) + (cosine * m_localSines[index]);
+		return true;
+	}
+
+	void TransformHierarchy::build()
+	{
+		m_structureDirty = false;
+		m_depths.clear();
+
+		// Roots make up the first depth
+		std::vector<uint32_t> order = {};
+		order.reserve(m_owners.size());
+
+		for (size_t i = 0; i < m_owners.size(); i++)
+			if (m_owners[i] != nullptr && m_parents[i] == noParent)
+				order.push_back(static_cast<uint32_t>(i));
+
+		// Children of every depth make up the next
+		for (size_t begin = 0; begin < order.size();)
+		{
+			size_t end = order.size();
+			m_depths.push_back(begin);
+
+			for (size_t i = begin; i < end; i++)
+				for (auto child : m_owners[order[i]]->m_children)
+					order.push_back(child->m_index);
+
+			begin = end;
+		}
+
+		m_depths.push_back(order.size());
+
+		// New index of every old row
+		std::vector<uint32_t> indices(m_owners.size(), noParent);
+		for (size_t i = 0; i < order.size(); i++)
+			indices[order[i]] = static_cast<uint32_t>(i);
+
+		permute(m_owners, order);
+		permute(m_parents, order);
+		permute(m_dirty, order);
+		forEachArray([&order](std::vector<float>& values) { permute(values, order); });
+
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			m_owners[i]->m_index = static_cast<uint32_t>(i);
+
+			if (m_parents[i] != noParent)
+				m_parents[i] = indices[m_parents[i]];
+		}
+	}
+
+	void TransformHierarchy::resolveRange(size_t begin, size_t end)
+	{
+		for (size_t first = begin; first < end; first += blockSize)
+		{
+			size_t count = std::min(blockSize, end - first);
+			const uint32_t* parents = m_parents.data() + first;
+			uint8_t* dirty = m_dirty.data() + first;
+
+			// Children of changed rows changed too
+			uint8_t changed = 0;
+			for (size_t i = 0; i < count; i++)
+			{
+				if (parents[i] != noParent)
+					dirty[i] |= m_dirty[parents[i]];
+
+				changed |= dirty[i];
+			}
+
+			// Unchanged blocks keep their world values
+			if (changed == 0)
+				continue;
+
+			// Gather the parents values next to each other, with roots placed by the identity...
+			float parentTranslationsX[blockSize];
+			float parentTranslationsY[blockSize];
+			float parentTranslationsZ[blockSize];
+			float parentScalesX[blockSize];
+			float parentScalesY[blockSize];
+			float parentRotations[blockSize];
+			float parentCosines[blockSize];
+			float parentSines[blockSize];
+
+			for (size_t i = 0; i < count; i++)
+			{
+				uint32_t parent = parents[i];
+				bool root = parent == noParent;
+
+				parentTranslationsX[i] = root ? 0.0f : m_translationsX[parent];
+				parentTranslationsY[i] = root ? 0.0f : m_translationsY[parent];
+				parentTranslationsZ[i] = root ? 0.0f : m_translationsZ[parent];
+				parentScalesX[i] = root ? 1.0f : m_localScalesX[parent];
+				parentScalesY[i] = root ? 1.0f : m_localScalesY[parent];
+				parentRotations[i] = root ? 0.0f : m_rotations[parent];
+				parentCosines[i] = root ? 1.0f : m_cosines[parent];
+				parentSines[i] = root ? 0.0f : m_sines[parent];
+			}
+
+			// ...so every row is the same branch free math over contiguous arrays,
+			// which is cheaper than testing each row and leaves the loop vectorizable
+			const float* localPositionsX = m_localPositionsX.data() + first;
+			const float* localPositionsY = m_localPositionsY.data() + first;
+			const float* localPositionsZ = m_localPositionsZ.data() + first;
+			const float* localRotations = m_localRotations.data() + first;
+			const float* localCosines = m_localCosines.data() + first;
+			const float* localSines = m_localSines.data() + first;
+
+			float translationsX[blockSize];
+			float translationsY[blockSize];
+			float translationsZ[blockSize];
+			float positionsX[blockSize];
+			float positionsY[blockSize];
+			float rotations[blockSize];
+			float cosines[blockSize];
+			float sines[blockSize];
+
+			for (size_t i = 0; i < count; i++)
+			{
+				float localX = localPositionsX[i];
+				float localY = localPositionsY[i];
+				float cosine = parentCosines[i];
+				float sine = parentSines[i];
+
+				// Children are placed by their parents unscaled transformation...
+				translationsX[i] = parentTranslationsX[i] + (cosine * localX) - (sine * localY);
+				translationsY[i] = parentTranslationsY[i] + (sine * localX) + (cosine * localY);
+				translationsZ[i] = parentTranslationsZ[i] + localPositionsZ[i];
+
+				// ...while their position goes through the scaled one
+				float scaledX = localX * parentScalesX[i];
+				float scaledY = localY * parentScalesY[i];
+				positionsX[i] = parentTranslationsX[i] + (cosine * scaledX) - (sine * scaledY);
+				positionsY[i] = parentTranslationsY[i] + (sine * scaledX) + (cosine * scaledY);
+
+				// Angles add, so the cached local sine and cosine stand in for sin() and cos()
+				rotations[i] = parentRotations[i] + localRotations[i];
+				cosines[i] = (cosine * localCosines[i]) - (sine * localSines[i]);
+				sines[i] = (sine * localCosines[i]) + (cosine * localSines[i]);
+			}
+
+			std::copy(translationsX, translationsX + count, m_translationsX.begin() + first);
+			std::copy(translationsY, translationsY + count, m_translationsY.begin() + first);
+			std::copy(translationsZ, translationsZ + count, m_translationsZ.begin() + first);
+			std::copy(positionsX, positionsX + count, m_positionsX.begin() + first);
+			std::copy(positionsY, positionsY + count, m_positionsY.begin() + first);
+			std::copy(rotations, rotations + count, m_rotations.begin() + first);
+			std::copy(cosines, cosines + count, m_cosines.begin() + first);
+			std::copy(sines, sines + count, m_sines.begin() + first);
+		}
+	}
+}
\ No newline at end of file
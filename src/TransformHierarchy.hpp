@@ -0,0 +1,310 @@
+#pragma once
+
+/**
+ * @file TransformHierarchy.hpp
+ * @brief Transform hierarchy header file.
+ * @author Connor J. Bramham (ReeCocho)
+ */
+
+/** Includes. */
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <glm\glm.hpp>
+#include "Affine.hpp"
+
+namespace snk
+{
+	class Transform;
+
+	class ThreadPool;
+
+	/**
+	 * @class TransformHierarchy
+	 * @brief Storage for every transform of a scene.
+	 * @note Each transform owns one row, and every value lives in its own array, one per component,
+	 *		 so local values are read and world values written without touching the transforms.
+	 *		 Rows are kept breadth first, so parents always come before their children and every
+	 *		 depth of the tree is a contiguous range that can be split over the thread pool.
+	 *		 Setting a local value only flags its row. Children inherit the flag while resolving,
+	 *		 and blocks without a flagged row are skipped.
+	 *		 The order is only rebuilt after a transform is added, removed, or reparented.
+	 */
+	class TransformHierarchy
+	{
+		friend class Transform;
+
+	public:
+
+		/** Parent index of a root transform. */
+		static constexpr uint32_t noParent = std::numeric_limits<uint32_t>::max();
+
+		/** Transforms per job when resolving a depth in parallel. */
+		static constexpr size_t grainSize = 512;
+
+		/** Transforms checked for changes and resolved together. */
+		static constexpr size_t blockSize = 64;
+
+		/**
+		 * @brief Default constructor.
+		 */
+		TransformHierarchy() = default;
+
+		/**
+		 * @brief Resolve the world values of every changed transform.
+		 * @param Thread pool to split each depth over, or nullptr to resolve on the calling thread.
+		 * @note Clears every change flag. Must not run next to anything reading or writing transforms.
+		 */
+		void resolve(ThreadPool* threadPool);
+
+		/**
+		 * @brief Get the number of rows.
+		 * @return Number of rows.
+		 * @note Rows of removed transforms are only dropped by the next resolve.
+		 */
+		inline size_t size() const
+		{
+			return m_owners.size();
+		}
+
+		/**
+		 * @brief Get the number of depths in the tree.
+		 * @return Number of depths.
+		 */
+		inline size_t depthCount() const
+		{
+			return m_depths.empty() ? 0 : m_depths.size() - 1;
+		}
+
+	private:
+
+		/**
+		 * @brief Add a row.
+		 * @param Transform owning the row.
+		 * @return Index of the row.
+		 * @note The row is a root at the origin.
+		 */
+		uint32_t add(Transform* owner);
+
+		/**
+		 * @brief Remove a row.
+		 * @param Index of the row.
+		 * @note The row must not be the parent of another.
+		 */
+		void remove(uint32_t index);
+
+		/**
+		 * @brief Set the parent of a row.
+		 * @param Index of the row.
+		 * @param Index of the parent row, or noParent.
+		 */
+		void setParent(uint32_t index, uint32_t parent);
+
+		/**
+		 * @brief Flag a row as changed.
+		 * @param Index of the row.
+		 * @note Only writes the row, so rows may be flagged in parallel.
+		 */
+		inline void markDirty(uint32_t index)
+		{
+			m_dirty[index] = 1;
+			m_changed.store(true, std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief Get the local position of a row.
+		 * @param Index of the row.
+		 * @return Local position.
+		 */
+		inline glm::vec3 getLocalPosition(uint32_t index) const
+		{
+			return glm::vec3(m_localPositionsX[index], m_localPositionsY[index], m_localPositionsZ[index]);
+		}
+
+		/**
+		 * @brief Set the local position of a row.
+		 * @param Index of the row.
+		 * @param Local position.
+		 */
+		inline void setLocalPosition(uint32_t index, glm::vec3 value)
+		{
+			m_localPositionsX[index] = value.x;
+			m_localPositionsY[index] = value.y;
+			m_localPositionsZ[index] = value.z;
+			markDirty(index);
+		}
+
+		/**
+		 * @brief Set the local rotation of a row.
+		 * @param Index of the row.
+		 * @param Local rotation in degrees.
+		 * @note Caches the sine and cosine, so resolving never calls them.
+		 */
+		void setLocalRotation(uint32_t index, float value);
+
+		/**
+		 * @brief Set the local scale of a row.
+		 * @param Index of the row.
+		 * @param Local scale.
+		 */
+		inline void setLocalScale(uint32_t index, glm::vec2 value)
+		{
+			m_localScalesX[index] = value.x;
+			m_localScalesY[index] = value.y;
+			markDirty(index);
+		}
+
+		/**
+		 * @brief Get the world position of a row.
+		 * @param Index of the row.
+		 * @return Position.
+		 */
+		inline glm::vec3 getPosition(uint32_t index)
+		{
+			std::unique_lock<std::mutex> lock = resolveRow(index);
+			return glm::vec3(m_positionsX[index], m_positionsY[index], m_translationsZ[index]);
+		}
+
+		/**
+		 * @brief Get the world rotation of a row.
+		 * @param Index of the row.
+		 * @return Rotation in degrees.
+		 */
+		inline float getRotation(uint32_t index)
+		{
+			std::unique_lock<std::mutex> lock = resolveRow(index);
+			return m_rotations[index];
+		}
+
+		/**
+		 * @brief Get the right vector of a row.
+		 * @param Index of the row.
+		 * @return Cosine and sine of the world rotation.
+		 */
+		inline glm::vec2 getRight(uint32_t index)
+		{
+			std::unique_lock<std::mutex> lock = resolveRow(index);
+			return glm::vec2(m_cosines[index], m_sines[index]);
+		}
+
+		/**
+		 * @brief Get the model transformation of a row.
+		 * @param Index of the row.
+		 * @return Model transformation.
+		 */
+		Affine getModel(uint32_t index);
+
+		/**
+		 * @brief Resolve a row if it or one of its ancestors changed since the last resolve.
+		 * @param Index of the row.
+		 * @return Lock to hold while reading the row, which only owns the mutex if the row changed.
+		 * @note Safe for parallel readers. Flags are left alone so the rest of the subtree still
+		 *		 gets resolved, which means another reader may write the row again until the next
+		 *		 resolve, so changed rows are only ever read or written under the lock.
+		 */
+		std::unique_lock<std::mutex> resolveRow(uint32_t index);
+
+		/**
+		 * @brief Resolve the changed rows from the root down to a row.
+		 * @param Index of the row.
+		 * @return Was the row resolved?
+		 */
+		bool resolveChain(uint32_t index);
+
+		/**
+		 * @brief Rebuild the breadth first order, dropping removed rows.
+		 */
+		void build();
+
+		/**
+		 * @brief Resolve a range of rows of one depth.
+		 * @param First index.
+		 * @param One past the last index.
+		 * @note Parents of the range must already be resolved.
+		 */
+		void resolveRange(size_t begin, size_t end);
+
+		/**
+		 * @brief Run a function on every array of floats.
+		 * @param Function taking a vector of floats.
+		 */
+		template<class Function>
+		void forEachArray(Function function)
+		{
+			for (auto values : { &m_localPositionsX, &m_localPositionsY, &m_localPositionsZ, &m_localRotations, &m_localCosines, &m_localSines, &m_localScalesX, &m_localScalesY,
+				&m_positionsX, &m_positionsY, &m_translationsX, &m_translationsY, &m_translationsZ, &m_rotations, &m_cosines, &m_sines })
+				function(*values);
+		}
+
+		/** Serializes lazy resolves of the scenes transforms. */
+		std::mutex m_resolveMutex = {};
+
+		/** Has a row been flagged since the last resolve? */
+		std::atomic<bool> m_changed = { false };
+
+		/** Does the order need to be rebuilt? */
+		bool m_structureDirty = false;
+
+		/** Transform owning every row, or nullptr once removed. */
+		std::vector<Transform*> m_owners = {};
+
+		/** Index of every rows parent, or noParent. */
+		std::vector<uint32_t> m_parents = {};
+
+		/** First index of every depth, followed by the number of rows. */
+		std::vector<size_t> m_depths = {};
+
+		/** Has the row changed since the last resolve? One byte per row so rows can be flagged in parallel. */
+		std::vector<uint8_t> m_dirty = {};
+
+		/** Local position along the x axis. */
+		std::vector<float> m_localPositionsX = {};
+
+		/** Local position along the y axis. */
+		std::vector<float> m_localPositionsY = {};
+
+		/** Local position along the z axis. */
+		std::vector<float> m_localPositionsZ = {};
+
+		/** Local rotation in degrees. */
+		std::vector<float> m_localRotations = {};
+
+		/** Cosine of the local rotation. */
+		std::vector<float> m_localCosines = {};
+
+		/** Sine of the local rotation. */
+		std::vector<float> m_localSines = {};
+
+		/** Local scale along the x axis. */
+		std::vector<float> m_localScalesX = {};
+
+		/** Local scale along the y axis. */
+		std::vector<float> m_localScalesY = {};
+
+		/** World position along the x axis. */
+		std::vector<float> m_positionsX = {};
+
+		/** World position along the y axis. */
+		std::vector<float> m_positionsY = {};
+
+		/** World translation along the x axis. Children are placed by it without their parents scale. */
+		std::vector<float> m_translationsX = {};
+
+		/** World translation along the y axis. */
+		std::vector<float> m_translationsY = {};
+
+		/** World translation along the z axis, which is also the depth of the world position. */
+		std::vector<float> m_translationsZ = {};
+
+		/** World rotation in degrees. */
+		std::vector<float> m_rotations = {};
+
+		/** Cosine of the world rotation. */
+		std::vector<float> m_cosines = {};
+
+		/** Sine of the world rotation. */
+		std::vector<float> m_sines = {};
+	};
+}
\ No newline at end of file
@@ -18,4 +18,58 @@ namespace snk
 
 		return contents;
 	}
+
+	uint64_t hashBytes(const void* data, size_t size, uint64_t hash)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	void radixSort(const uint64_t* keys, size_t count, std::vector<uint32_t>& order, std::vector<uint32_t>& scratch)
+	{
+		order.resize(count);
+		scratch.resize(count);
+
+		for (size_t i = 0; i < count; i++)
+			order[i] = static_cast<uint32_t>(i);
+
+		// Count every byte of every key in one pass
+		size_t histograms[8][256] = {};
+		for (size_t i = 0; i < count; i++)
+			for (size_t pass = 0; pass < 8; pass++)
+				histograms[pass][(keys[i] >> (pass * 8)) & 0xFF]++;
+
+		for (size_t pass = 0; pass < 8; pass++)
+		{
+			size_t* histogram = histograms[pass];
+
+			// Every key has the same byte, so the pass wouldn't move anything
+			if (count == 0 || histogram[(keys[0] >> (pass * 8)) & 0xFF] == count)
+				continue;
+
+			// Turn counts into offsets
+			size_t offset = 0;
+			for (size_t i = 0; i < 256; i++)
+			{
+				size_t bucket = histogram[i];
+				histogram[i] = offset;
+				offset += bucket;
+			}
+
+			for (size_t i = 0; i < count; i++)
+			{
+				uint32_t index = order[i];
+				scratch[histogram[(keys[index] >> (pass * 8)) & 0xFF]++] = index;
+			}
+
+			order.swap(scratch);
+		}
+	}
 }
\ No newline at end of file
@@ -8,6 +8,8 @@
 
 /** Includes. */
 #include <string>
+#include <vector>
+#include <cstdint>
 
 namespace snk
 {
@@ -17,4 +19,23 @@ namespace snk
 	 * @return Contents of the text file.
 	 */
 	std::string readTextFile(const std::string& path);
+
+	/**
+	 * @brief Hash bytes with 64 bit FNV-1a.
+	 * @param Bytes to hash.
+	 * @param Number of bytes.
+	 * @param Hash to continue from, so several buffers can be hashed together.
+	 * @return Hash.
+	 */
+	uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull);
+
+	/**
+	 * @brief Stable sort of indices by 64 bit keys using a least significant byte radix sort.
+	 * @param Keys to sort by.
+	 * @param Number of keys.
+	 * @param Receives the indices of the keys in ascending key order.
+	 * @param Scratch buffer. Kept between calls to avoid allocating.
+	 * @note Bytes every key shares are skipped.
+	 */
+	void radixSort(const uint64_t* keys, size_t count, std::vector<uint32_t>& order, std::vector<uint32_t>& scratch);
 }
\ No newline at end of file